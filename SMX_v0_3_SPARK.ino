@@ -6,27 +6,45 @@
 #include "lora_handler.h"
 #include "eeprom_manager.h"
 #include "power_manager.h"
+#include "aggregator.h"
+#include "trace_recorder.h"
+#include "payload_codec.h"
+#include "measurement_queue.h"
+#include "event_queue.h"
+#include "wake_scheduler.h"
+#include "signal_chain.h"
+#include "channel_scheduler.h"
+#include "latency_window.h"
 
 uint8_t retryCount = 0;
 
 // Global instances
+#if SMX_STATIC_ALLOC
+static ImpedanceMeter impedanceMeterInstance;
+static PowerManager powerManagerInstance;
+static LoRaWANHandler loraHandlerInstance;
+ImpedanceMeter* impedanceMeter = &impedanceMeterInstance;
+PowerManager* powerManager = &powerManagerInstance;
+LoRaWANHandler* loraHandler = &loraHandlerInstance;
+#else
 ImpedanceMeter* impedanceMeter = nullptr;
 PowerManager* powerManager = nullptr;
 LoRaWANHandler* loraHandler = nullptr;
+#endif
 //EEPROMManager* eepromManager = nullptr;
-TemperatureSensor* tempSensor = nullptr;
+TemperatureSensor tempSensor;
 ExternalEEPROM eeprom;
 EEPROMManager eepromManager(eeprom);
+Aggregator aggregator;
+TraceRecorder trace;
 
 // Hardware instances
 PCA9536 io;
-TMP102 STemp;
 //Adafruit_EEPROM_I2C LoraMem;
 
 // Global state variables
 SystemState currentState = SystemState::INIT;
 SensorConfig config;
-bool measurementRequested = false;
 
 uint32_t startupTime = 0;
 uint32_t cycleCount = 0;
@@ -36,18 +54,47 @@ const uint32_t TEST_DURATION_MS = 10 * 60 * 1000; // 10 minutes test duration
 bool initializeSensors();
 
 // Measurement data
-int8_t HL = 0;
-int8_t HH = 0;
+int8_t Moisture[ChannelConfig::MAX_CHANNELS] = {};
 int Temp = 0;
 int8_t Batt = 0;
 uint16_t SNr = 0;
 uint32_t Time = 0;
 uint32_t lastWakeupTime = 0;
+uint32_t measureCycle = 0;
+uint8_t muxState = 0;          // PCA9536 output levels, bit n = IO n
 
 // Task management
-SemaphoreHandle_t taskEvent = nullptr;
 SoftwareTimer taskWakeupTimer;
-int8_t eventType = -1;
+EventQueue eventQueue;
+WakeScheduler wakeScheduler;
+uint32_t nextWakeMs = 0;
+MeasurementQueue measurementQueue;
+SoftwareTimer latencyTimer;
+LatencyWindow latencyWindow;
+uint8_t deferredLatencyMinutes = 0;     // Latency request waiting for Class A, sensor task only
+LatencyWindow::Mode deferredLatencyMode = LatencyWindow::OFF;
+TaskHandle_t sensorTaskHandle = nullptr;
+TaskHandle_t radioTaskHandle = nullptr;
+#if SMX_STATIC_ALLOC
+static StackType_t sensorStack[TaskConfig::SENSOR_STACK];
+static StackType_t radioStack[TaskConfig::RADIO_STACK];
+static StaticTask_t sensorTaskBuffer;
+static StaticTask_t radioTaskBuffer;
+#endif
+
+// RAM per subsystem, see MemoryBudget
+constexpr uint32_t SENSOR_RAM = sizeof(ImpedanceMeter) + sizeof(TemperatureSensor) + sizeof(PowerManager) +
+                                sizeof(TraceRecorder) + TaskConfig::SENSOR_STACK * sizeof(StackType_t);
+constexpr uint32_t RADIO_RAM = sizeof(LoRaWANHandler) + sizeof(Aggregator) + sizeof(LatencyWindow) +
+                               TaskConfig::RADIO_STACK * sizeof(StackType_t);
+constexpr uint32_t TASKS_RAM = sizeof(EventQueue) + sizeof(MeasurementQueue) + sizeof(WakeScheduler);
+constexpr uint32_t STORAGE_RAM = sizeof(EEPROMManager) + sizeof(ExternalEEPROM);
+
+static_assert(SENSOR_RAM <= MemoryBudget::SENSOR_RAM, "Sensor subsystem exceeds its RAM budget");
+static_assert(RADIO_RAM <= MemoryBudget::RADIO_RAM, "Radio subsystem exceeds its RAM budget");
+static_assert(TASKS_RAM <= MemoryBudget::TASKS_RAM, "Task plumbing exceeds its RAM budget");
+static_assert(STORAGE_RAM <= MemoryBudget::STORAGE_RAM, "Storage subsystem exceeds its RAM budget");
+static_assert(Aggregator::MAX_SUMMARY_SIZE <= LoRaConfig::DATA_BUFF_SIZE, "Summary frame exceeds the LoRa buffer");
 
 void setup() {
   startupTime = millis();
@@ -93,12 +140,17 @@ bool initializeSensors() {
     } else {
         io.pinMode(Pins::EN_SEL, OUTPUT);  // Use Pins namespace
         io.pinMode(Pins::C_SEL, OUTPUT);   // Use Pins namespace
+        io.pinMode(Pins::PROBE_SEL0, OUTPUT);
+        io.pinMode(Pins::PROBE_SEL1, OUTPUT);
         io.write(Pins::EN_SEL, LOW);
         io.write(Pins::C_SEL, HIGH);
+        io.write(Pins::PROBE_SEL0, LOW);
+        io.write(Pins::PROBE_SEL1, LOW);
+        muxState = 1 << Pins::C_SEL;
     }
     
     // Initialize temperature sensor
-    if (!STemp.begin()) {
+    if (!tempSensor.initialize()) {
         Serial.println("TMP102 not detected");
         success = false;
     }
@@ -113,10 +165,163 @@ bool initializeSensors() {
 
 // Callback implementations
 void handleMeasurementRequest() {
-    measurementRequested = true;
-    if (taskEvent) {
-        xSemaphoreGive(taskEvent);
+    eventQueue.post(EventType::DOWNLINK_COMMAND, EventSource::LORA_RX, 0x02);
+}
+
+void handleTimeSync(uint32_t epochSeconds) {
+    eventQueue.post(EventType::DOWNLINK_COMMAND, EventSource::LORA_RX, 0x05, epochSeconds);
+}
+
+void handleLatencyRequest(uint8_t minutes, uint8_t mode) {
+    eventQueue.post(EventType::DOWNLINK_COMMAND, EventSource::LORA_RX, 0x06, ((uint32_t)mode << 8) | minutes);
+}
+
+void latencyTimeout(TimerHandle_t unused) {
+    eventQueue.post(EventType::LATENCY_TICK, EventSource::LATENCY_TIMER);
+}
+
+void armLatencyTimer(uint32_t ms) {
+    latencyTimer.stop();
+    latencyTimer.setPeriod(ms);
+    latencyTimer.start();
+}
+
+// Empty uplinks and class switches run in the radio task, in order with
+// the measurement uplinks
+void queueRadioCommand(RadioCommand command) {
+    MeasurementRecord record = {};
+    record.timestamp = millis();
+    record.command = command;
+    measurementQueue.push(record);
+}
+
+// Ends the latency window. A Class C window keeps being charged and the
+// Class A request is retried until the MAC confirms the switch. Only called
+// from the sensor task, like the other latency window functions.
+void closeLatencyWindow() {
+    if (!latencyWindow.isOpen() || latencyWindow.isClosing()) {
+        return;
+    }
+    if (latencyWindow.mode() == LatencyWindow::CLASS_C) {
+        latencyWindow.startClosing();
+        queueRadioCommand(RadioCommand::REQUEST_CLASS_A);
+        armLatencyTimer(LatencyConfig::CLASS_RETRY_MS);
+        Serial.println("Latency window ended, returning to class A");
+        return;
     }
+    latencyTimer.stop();
+    latencyWindow.close(millis());
+    Serial.printf("Latency window closed, %lu mAs of daily budget left\n",
+                  latencyWindow.remainingChargeMas(millis()));
+}
+
+// Applies downlink 0x06, minutes 0 ends the window. The budget may shorten
+// or refuse the window. A Class C window only ends once Class A is
+// confirmed, so a request arriving before that waits for it.
+void openLatencyWindow(uint8_t minutes, LatencyWindow::Mode mode) {
+    closeLatencyWindow();
+    if (latencyWindow.isClosing()) {
+        deferredLatencyMinutes = minutes;
+        deferredLatencyMode = mode;
+        return;
+    }
+    if (minutes == 0) {
+        return;
+    }
+
+    uint32_t uplinkMs = LoRaWANHandler::airtimeMs(0);
+    uint32_t granted = latencyWindow.open(mode, minutes, millis(), uplinkMs);
+    if (!granted) {
+        Serial.println("Latency window refused, daily budget used up");
+        return;
+    }
+
+    Serial.printf("Latency window: %s for %lu s, %lu uA average\n",
+                  mode == LatencyWindow::CLASS_C ? "class C" : "uplink burst", granted / 1000,
+                  LatencyWindow::drawUa(mode, uplinkMs));
+    if (mode == LatencyWindow::BURST) {
+        queueRadioCommand(RadioCommand::EMPTY_UPLINK);
+        armLatencyTimer(min(granted, LatencyConfig::BURST_INTERVAL_MS));
+    } else {
+        queueRadioCommand(RadioCommand::REQUEST_CLASS_C);
+        armLatencyTimer(granted);
+    }
+}
+
+// Class A confirmed, stops charging the Class C window and applies a
+// request that arrived while it was closing
+void finishLatencyWindow() {
+    latencyTimer.stop();
+    latencyWindow.close(millis());
+    Serial.printf("Latency window closed, %lu mAs of daily budget left\n",
+                  latencyWindow.remainingChargeMas(millis()));
+    if (deferredLatencyMinutes) {
+        uint8_t minutes = deferredLatencyMinutes;
+        deferredLatencyMinutes = 0;
+        openLatencyWindow(minutes, deferredLatencyMode);
+    }
+}
+
+// Class switch result from the MAC or the radio task
+void handleClassChanged(DeviceClass_t deviceClass, bool confirmed) {
+    bool classCWindow = latencyWindow.isOpen() && latencyWindow.mode() == LatencyWindow::CLASS_C;
+    if (deviceClass == CLASS_A) {
+        if (confirmed && latencyWindow.isClosing()) {
+            finishLatencyWindow();
+        }
+        // Refused: the latency timer retries while the window is closing
+    } else if (!confirmed) {
+        if (classCWindow && !latencyWindow.isClosing()) {
+            // The MAC refused Class C, an uplink burst covers the rest of the window
+            uint32_t remaining = latencyWindow.remainingMs(millis());
+            latencyWindow.close(millis());
+            openLatencyWindow((remaining + 59999) / 60000, LatencyWindow::BURST);
+        }
+    } else if (!classCWindow) {
+        // A late Class C confirmation after the window ended
+        queueRadioCommand(RadioCommand::REQUEST_CLASS_A);
+    }
+}
+
+// Latency timer: sends the next burst uplink, ends the window or retries
+// the switch back to Class A
+void handleLatencyTick() {
+    uint32_t now = millis();
+    if (!latencyWindow.isOpen()) {
+        return;
+    }
+    if (latencyWindow.isClosing()) {
+        queueRadioCommand(RadioCommand::REQUEST_CLASS_A);
+        armLatencyTimer(LatencyConfig::CLASS_RETRY_MS);
+        return;
+    }
+    if (latencyWindow.expired(now)) {
+        closeLatencyWindow();
+        return;
+    }
+
+    uint32_t remaining = latencyWindow.remainingMs(now);
+    if (latencyWindow.mode() == LatencyWindow::BURST) {
+        queueRadioCommand(RadioCommand::EMPTY_UPLINK);
+        armLatencyTimer(min(remaining, LatencyConfig::BURST_INTERVAL_MS));
+    } else {
+        armLatencyTimer(remaining);     // Timer ticks can run slightly short of the window
+    }
+}
+
+// Arms the one-shot wake timer for the next absolute slot. Only called from
+// the sensor task, which owns the scheduler.
+void armWakeTimer() {
+    uint32_t now = millis();
+    nextWakeMs = wakeScheduler.nextWake(now, SystemConstants::MIN_TO_MS(config.DS_min));
+    Time = nextWakeMs - now;
+
+    taskWakeupTimer.stop();
+    taskWakeupTimer.setPeriod(Time);
+    taskWakeupTimer.start();
+    Serial.printf("Next wake in %lu ms (phase %lu ms, %lu slots missed)\n", Time,
+                  wakeScheduler.phaseMs(SystemConstants::MIN_TO_MS(config.DS_min)),
+                  wakeScheduler.missedSlots());
 }
 
 /*
@@ -136,7 +341,55 @@ void handleIntervalUpdate(uint8_t newInterval) {
     
 }*/
 
+// Boot-time RAM report per subsystem; extras/footprint gives the full
+// RAM/flash breakdown from the linked image
+void printFootprint() {
+    Serial.printf("RAM (%s): sensor %lu/%lu, radio %lu/%lu, tasks %lu/%lu, storage %lu/%lu bytes\n",
+                  SMX_STATIC_ALLOC ? "static" : "heap",
+                  SENSOR_RAM, MemoryBudget::SENSOR_RAM, RADIO_RAM, MemoryBudget::RADIO_RAM,
+                  TASKS_RAM, MemoryBudget::TASKS_RAM, STORAGE_RAM, MemoryBudget::STORAGE_RAM);
+}
+
+// Single-sample frame length for a channel mask
+uint8_t sampleSize(uint8_t mask) {
+    return (mask == ChannelConfig::LEGACY_MASK) ? PayloadCodec::SAMPLE_SIZE : PayloadCodec::channelsSize(mask);
+}
+
+// Aggregated samples only live in RAM, so a summary has to be due before
+// the daily reset or its samples are lost
+bool summaryFitsDay(uint8_t dsMin, uint8_t reportEvery) {
+    return (uint32_t)dsMin * reportEvery < SystemConstants::RESET_AFTER_S / 60;
+}
+
+// Warns when the configured interval and report period need more airtime
+// than the hourly duty cycle budget; excess uplinks are then deferred.
+void checkAirtimeBudget() {
+    bool summary = config.reportEvery > 1;
+    uint8_t mask = (1 << config.channelCount) - 1;
+    uint32_t frameMs = LoRaWANHandler::airtimeMs(summary ? Aggregator::summarySize(mask) : sampleSize(mask));
+    uint32_t periodMs = SystemConstants::MIN_TO_MS(config.DS_min) * config.reportEvery;
+    uint32_t hourlyMs = (periodMs > 0) ? (uint64_t)frameMs * DutyCycleBudget::WINDOW_MS / periodMs : 0;
+    uint32_t limitMs = DutyCycleBudget::limitMs(DutyCycleBudget::BAND_G);
+
+    Serial.printf("Expected airtime: %lu of %lu ms per hour\n", hourlyMs, limitMs);
+    if (hourlyMs > limitMs) {
+        Serial.println("WARNING: Duty cycle limit exceeded, uplinks will be deferred");
+    }
+    if (!summaryFitsDay(config.DS_min, config.reportEvery)) {
+        Serial.println("WARNING: Summary period exceeds the daily reset, samples will be lost");
+    }
+}
+
 void handleIntervalUpdate(uint8_t newInterval) {
+    if (newInterval == 0) {
+        Serial.println("Invalid interval: 0");
+        return;
+    }
+    if (!summaryFitsDay(newInterval, config.reportEvery)) {
+        Serial.printf("Invalid interval: %d min x %d samples exceeds the daily reset\n",
+                      newInterval, config.reportEvery);
+        return;
+    }
     if (config.DS_min != newInterval) {
         uint8_t oldInterval = config.DS_min;  // Save old value
         config.DS_min = newInterval;
@@ -147,11 +400,9 @@ void handleIntervalUpdate(uint8_t newInterval) {
             Serial.print(" -> ");
             Serial.println(newInterval);
             
-            // Only update timer if EEPROM write was successful
-            Time = SystemConstants::MIN_TO_MS(config.DS_min);
-            taskWakeupTimer.stop();
-            taskWakeupTimer.begin(Time, periodicWakeup);
-            taskWakeupTimer.start();
+            // Only move the schedule if EEPROM write was successful
+            eventQueue.post(EventType::DOWNLINK_COMMAND, EventSource::LORA_RX, 0x01);
+            checkAirtimeBudget();
         } else {
             config.DS_min = oldInterval;  // Revert to old value if write failed
             Serial.println("Eroare la scriere in EEPROM!");
@@ -159,6 +410,30 @@ void handleIntervalUpdate(uint8_t newInterval) {
     }
 }
 
+void handleReportUpdate(uint8_t reportEvery) {
+    if (reportEvery == 0 || reportEvery > AggregationConfig::MAX_REPORT_EVERY) {
+        Serial.printf("Invalid report period: %d\n", reportEvery);
+        return;
+    }
+    if (!summaryFitsDay(config.DS_min, reportEvery)) {
+        Serial.printf("Invalid report period: %d x %d min exceeds the daily reset\n",
+                      reportEvery, config.DS_min);
+        return;
+    }
+    if (config.reportEvery != reportEvery) {
+        uint8_t oldReportEvery = config.reportEvery;
+        config.reportEvery = reportEvery;
+
+        if (eepromManager.writeConfig(config)) {
+            Serial.printf("Report period: %d -> %d measurements\n", oldReportEvery, reportEvery);
+            checkAirtimeBudget();
+        } else {
+            config.reportEvery = oldReportEvery;
+            Serial.println("Eroare la scriere in EEPROM!");
+        }
+    }
+}
+
 /*
 void handleIntervalUpdate(uint8_t newInterval) {
     if (config.DS_min != newInterval) {
@@ -199,9 +474,12 @@ void initializeSystem() {
 
     // Create instances
     Serial.println("Creating component instances...");
+#if !SMX_STATIC_ALLOC
     impedanceMeter = new ImpedanceMeter();
     powerManager = new PowerManager();
     loraHandler = new LoRaWANHandler();
+#endif
+    printFootprint();
     //eepromManager = new EEPROMManager(LoraMem);
     if (!eepromManager.initialize()) {
         Serial.println("Failed to initialize EEPROM");
@@ -209,7 +487,8 @@ void initializeSystem() {
     Serial.println("Component instances created");
 
     // Set up LoRaWAN callbacks
-    loraHandler->setCallbacks(handleMeasurementRequest, handleIntervalUpdate);
+    loraHandler->setCallbacks(handleMeasurementRequest, handleIntervalUpdate, handleReportUpdate,
+                              handleTimeSync, handleLatencyRequest);
     Serial.println("LoRaWAN callbacks configured");
 
     // Initialize hardware
@@ -223,12 +502,8 @@ void initializeSystem() {
     
     // Initialize task management
     Serial.println("Initializing task management...");
-    taskEvent = xSemaphoreCreateBinary();
-    if (taskEvent == NULL) {
-        Serial.println("ERROR: Failed to create semaphore!");
-    } else {
-        Serial.println("Task semaphore created");
-    }
+    // The event queue is static; events posted before the sensor task
+    // starts stay queued until it drains them
     
     // In initializeSystem()
     Serial.println("Reading EEPROM configuration...");
@@ -256,10 +531,13 @@ void initializeSystem() {
         Serial.println("Configuration loaded:");
         Serial.printf("- Sleep time: %d minutes\n", config.DS_min);
         Serial.printf("- Serial number: %d\n", config.SNr);
+        Serial.printf("- Report every: %d measurements\n", config.reportEvery);
+        checkAirtimeBudget();
     }
+    wakeScheduler.setIdentity(LoRaWANHandler::getDeviceEUI(), 8, config.SNr);
     
-    // Initialize time
-    Time = 15000; // Initial 20s interval
+    // First wake after 15 s, then on the node's slot
+    Time = 15000;
     Serial.printf("Initial interval set to: %d ms\n", Time);
     
     // Initialize components
@@ -281,8 +559,32 @@ void initializeSystem() {
     }
     
     Serial.println("Starting wake timer...");
-    taskWakeupTimer.begin(Time, periodicWakeup);
+    taskWakeupTimer.begin(Time, periodicWakeup, nullptr, false);
     taskWakeupTimer.start();
+    nextWakeMs = millis() + Time;
+    latencyTimer.begin(LatencyConfig::BURST_INTERVAL_MS, latencyTimeout, nullptr, false);
+
+    Serial.println("Creating tasks...");
+    if (!measurementQueue.begin()) {
+        Serial.println("ERROR: Failed to create measurement queue!");
+    }
+#if SMX_STATIC_ALLOC
+    sensorTaskHandle = xTaskCreateStatic(sensorTask, "sensor", TaskConfig::SENSOR_STACK, nullptr,
+                                         TaskConfig::SENSOR_PRIORITY, sensorStack, &sensorTaskBuffer);
+    radioTaskHandle = xTaskCreateStatic(radioTask, "radio", TaskConfig::RADIO_STACK, nullptr,
+                                        TaskConfig::RADIO_PRIORITY, radioStack, &radioTaskBuffer);
+#else
+    xTaskCreate(sensorTask, "sensor", TaskConfig::SENSOR_STACK, nullptr,
+                TaskConfig::SENSOR_PRIORITY, &sensorTaskHandle);
+    xTaskCreate(radioTask, "radio", TaskConfig::RADIO_STACK, nullptr,
+                TaskConfig::RADIO_PRIORITY, &radioTaskHandle);
+#endif
+    if (!sensorTaskHandle) {
+        Serial.println("ERROR: Failed to create sensor task!");
+    }
+    if (!radioTaskHandle) {
+        Serial.println("ERROR: Failed to create radio task!");
+    }
 
     Serial.println("Initialization complete!");
     Serial.println("===========================\n");
@@ -290,8 +592,58 @@ void initializeSystem() {
 }
 
 
+// Sensing and radio run in their own tasks, loop() has nothing left to do
 void loop() {
-    handleState();
+    vTaskSuspend(NULL);
+}
+
+// Sensor task: wake, measure, queue the record and power the front end down
+void sensorTask(void* arg) {
+    eventQueue.setConsumer(xTaskGetCurrentTaskHandle());
+    for (;;) {
+        handleState();
+    }
+}
+
+// Radio task: aggregates queued records and transmits while the sensor
+// front end sleeps. Records stay queued while the node is not joined.
+void radioTask(void* arg) {
+    MeasurementRecord record;
+
+    for (;;) {
+        if (!measurementQueue.peek(record, portMAX_DELAY)) {
+            continue;
+        }
+        if (!lmh_join_status_get()) {
+            // Woken early by a JOIN_RESULT event, polled as a fallback
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TaskConfig::JOIN_POLL_MS));
+            continue;
+        }
+        if (!measurementQueue.pop(record)) {
+            continue;
+        }
+        if (!record.mask) {
+            // Latency window work, nothing to aggregate
+            if (record.command == RadioCommand::EMPTY_UPLINK) {
+                loraHandler->sendData(nullptr, 0);
+                vTaskDelay(pdMS_TO_TICKS(TaskConfig::RX_WINDOW_MS));
+            } else {
+                DeviceClass_t deviceClass = record.command == RadioCommand::REQUEST_CLASS_C ? CLASS_C : CLASS_A;
+                if (!loraHandler->requestClass(deviceClass)) {
+                    eventQueue.post(EventType::CLASS_CHANGED, EventSource::RADIO_TASK, deviceClass, 0);
+                }
+            }
+            continue;
+        }
+
+        aggregator.addSample(record.moisture, record.mask, record.Temp);
+        if (aggregator.reportDue(config.reportEvery)) {
+            handleTransmitState(record);
+        } else {
+            Serial.printf("Aggregated sample %d of %d\n",
+                          aggregator.sampleCount(), config.reportEvery);
+        }
+    }
 }
 
 void handleState() {
@@ -302,9 +654,6 @@ void handleState() {
         case SystemState::MEASUREMENT:
             handleMeasurementState();
             break;
-        case SystemState::TRANSMIT:
-            handleTransmitState();
-            break;
         case SystemState::SLEEP:
             handleSleepState();
             break;
@@ -318,84 +667,221 @@ void handleInitState() {
     }
 }
 
-void handleMeasurementState() {
-    if (xSemaphoreTake(taskEvent, portMAX_DELAY) == pdTRUE && measurementRequested) {
-        Serial.println("\nStarting measurement cycle...");
-        lastWakeupTime = millis();
-        
-        powerManager->wakeUp();
-        delay(100);
-        
-        // Read battery level
-        Batt = powerManager->getBatteryLevel();
-        Serial.printf("Battery level: %d%%\n", Batt);
-        
-        // Read temperature
-        Temp = tempSensor->getTemperature();
-        Serial.printf("Temperature: %d?C\n", Temp);
-        
-        // Get moisture readings
-        io.write(Pins::C_SEL, HIGH);
-        delay(10);
-        HL = impedanceMeter->getMoisture(config.gainL, config.CminL, config.CmaxL, Temp);
-        Serial.printf("Low-gain moisture: %d%%\n", HL);
-        
-        io.write(Pins::C_SEL, LOW);
-        delay(10);
-        
-        HH = impedanceMeter->getMoisture(config.gainH, config.CminH, config.CmaxH, Temp);
-        Serial.printf("High-gain moisture: %d%%\n", HH);
-        
-        if (HL >= 0 && HH >= 0) {
-            Serial.println("Measurements successful, moving to transmission");
-            currentState = SystemState::TRANSMIT;
-        } else {
-            Serial.println("ERROR: Invalid measurements!");
+// Drives only the PCA9536 lines that differ from the current state and
+// lets the front end settle when something switched
+void selectChannel(uint8_t mux) {
+    uint8_t changed = (mux ^ muxState) & ChannelConfig::MUX_MASK;
+    if (!changed) {
+        return;
+    }
+    for (uint8_t line = 0; line < 4; line++) {
+        if (changed & (1 << line)) {
+            io.write(line, (mux >> line) & 1 ? HIGH : LOW);
         }
-        
-        measurementRequested = false;
     }
+    muxState ^= changed;
+    delay(ChannelConfig::SETTLE_MS);
 }
 
-void handleTransmitState() {
-    Serial.println("Preparing LoRaWAN transmission...");
+// Measures the channels due this cycle and hands the record to the radio task
+void runMeasurement() {
+    Serial.println("\nStarting measurement cycle...");
+    lastWakeupTime = millis();
+    trace.beginCycle(lastWakeupTime);
     
-    uint8_t payload[9];
-    payload[0] = HL & 0xFF;
-    payload[1] = (HL >> 8) & 0xFF;
-    payload[2] = HH & 0xFF;
-    payload[3] = (HH >> 8) & 0xFF;
-    payload[4] = Temp;
-    payload[5] = Batt;
-    payload[6] = config.SNr & 0xFF;
-    //Serial.println(Batt);
-    payload[7] = (config.SNr >> 8) & 0xFF;
-    //Serial.println(Batt);
-    payload[8] = config.DS_min;
-    //Serial.println(Batt);
+    powerManager->wakeUp();
+    delay(100);
+    
+    // TMP102 converts while the battery is sampled
+    tempSensor.startConversion(lastWakeupTime);
+    
+    // Read battery level
+    Batt = powerManager->getBatteryLevel();
+    Serial.printf("Battery level: %d%%\n", Batt);
+    
+    // Read temperature, in 1/16 C
+    int16_t temp16 = tempSensor.read(lastWakeupTime);
+    float tempC = SignalChain::celsius(temp16);
+    Temp = SignalChain::temperature(temp16);
+    Serial.printf("Temperature: %.2f?C%s\n", tempC, tempSensor.lastWasPredicted() ? " (predicted)" : "");
+    
+    // Get moisture readings, ordered to switch as few mux lines as possible
+    uint8_t order[ChannelConfig::MAX_CHANNELS];
+    uint8_t planned = ChannelScheduler::plan(config.channels, config.channelCount, measureCycle++,
+                                             muxState, order);
+    uint8_t mask = 0;
+    memset(Moisture, -1, sizeof(Moisture));
+    
+    for (uint8_t i = 0; i < planned; i++) {
+        uint8_t ch = order[i];
+        const ProbeChannel& channel = config.channels[ch];
+        selectChannel(channel.mux);
+        trace.beginChannel(ch, channel.gain, channel.Cmin, channel.Cmax);
+        Moisture[ch] = impedanceMeter->getMoisture(channel.gain, channel.Cmin, channel.Cmax, tempC);
+        Serial.printf("Channel %d moisture: %d%%\n", ch, Moisture[ch]);
+        if (Moisture[ch] >= 0) {
+            mask |= 1 << ch;
+        } else {
+            Serial.printf("ERROR: Invalid measurement on channel %d!\n", ch);
+        }
+    }
+    trace.recordResult(Moisture[0], Moisture[1], Temp, Batt);
+    
+    if (mask) {
+        MeasurementRecord record = { lastWakeupTime, 0, {}, mask, (int16_t)Temp, Batt };
+        memcpy(record.moisture, Moisture, sizeof(record.moisture));
+        measurementQueue.push(record);
+        Serial.printf("Measurements successful, queued (%d waiting)\n", measurementQueue.depth());
+    } else if (planned) {
+        Serial.println("ERROR: Invalid measurements!");
+    }
+    
+    // The cycle is over either way; SLEEP re-arms the one-shot wake timer
+    eventQueue.post(EventType::SENSOR_READY, EventSource::SENSOR_TASK, measurementQueue.depth());
+}
+
+// Blocks on the event queue and dispatches one event. Timer ticks and
+// measure commands start a cycle, a completed cycle moves to SLEEP.
+void handleMeasurementState() {
+    Event event;
+    eventQueue.wait(event);
+
+    switch (event.type) {
+        case EventType::TIMER_TICK:
+            Serial.printf("Wake %ld ms after slot\n", (int32_t)(millis() - nextWakeMs));
+            runMeasurement();
+            break;
+        case EventType::DOWNLINK_COMMAND:
+            if (event.arg == 0x02) {
+                runMeasurement();
+            } else if (event.arg == 0x01) {
+                armWakeTimer();
+            } else if (event.arg == 0x05) {
+                // The epoch held when the downlink was posted, not when it is dispatched
+                wakeScheduler.sync((uint64_t)event.timestamp * 1000 / configTICK_RATE_HZ,
+                                   (uint64_t)event.value * 1000);
+                Serial.printf("Time synced to %lu s\n", event.value);
+                armWakeTimer();
+            } else if (event.arg == 0x06) {
+                // value: mode << 8 | minutes, as sent in the downlink
+                openLatencyWindow(event.value & 0xFF, (event.value >> 8) ? LatencyWindow::BURST
+                                                                          : LatencyWindow::CLASS_C);
+            }
+            break;
+        case EventType::JOIN_RESULT:
+            if (event.arg && radioTaskHandle) {
+                xTaskNotifyGive(radioTaskHandle);
+            }
+            break;
+        case EventType::TX_DONE:
+            Serial.printf("Uplink %s\n", event.arg ? "done" : "failed or deferred");
+            break;
+        case EventType::SENSOR_READY:
+            currentState = SystemState::SLEEP;
+            break;
+        case EventType::CLASS_CHANGED:
+            handleClassChanged((DeviceClass_t)event.arg, event.value);
+            break;
+        case EventType::LATENCY_TICK:
+            handleLatencyTick();
+            break;
+        default:
+            break;
+    }
+}
+
+bool transmitSummary(const MeasurementRecord& record) {
+    uint8_t payload[Aggregator::MAX_SUMMARY_SIZE];
+    uint8_t length = aggregator.encodeSummary(payload, sizeof(payload), record.Batt, config.SNr,
+                                              config.DS_min, config.reportEvery,
+                                              loraHandler->dutyCycleUsage());
+    uint8_t mask = aggregator.channelMask();
+
+    Serial.printf("Summary of %d samples:\n", aggregator.sampleCount());
+    for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+        if (mask & (1 << ch)) {
+            const RunningStats& s = aggregator.channel(ch);
+            Serial.printf("Channel %d moisture: min %d, max %d, mean %.2f\n", ch, (int)s.min, (int)s.max, s.mean);
+        }
+    }
+
+    uint8_t port = (mask == ChannelConfig::LEGACY_MASK) ? AggregationConfig::SUMMARY_PORT
+                                                         : ChannelConfig::SUMMARY_PORT;
+    return loraHandler->sendData(payload, length, port);
+}
+
+bool transmitSample(const MeasurementRecord& record) {
+    uint8_t payload[PayloadCodec::MAX_CHANNELS_SIZE];
+    bool legacy = record.mask == ChannelConfig::LEGACY_MASK;
+    uint8_t length = legacy
+        ? PayloadCodec::encodeSample(payload, sizeof(payload), record.moisture[0], record.moisture[1],
+                                     record.Temp, record.Batt, config.SNr, config.DS_min,
+                                     loraHandler->dutyCycleUsage())
+        : PayloadCodec::encodeChannels(payload, sizeof(payload), record.moisture, record.mask,
+                                       record.Temp, record.Batt, config.SNr, config.DS_min,
+                                       loraHandler->dutyCycleUsage());
 
     // Print interpreted data
     Serial.println("Payload contents:");
-    Serial.printf("Low-gain moisture: %d%%\n", HL);
-    Serial.printf("High-gain moisture: %d%%\n", HH);
-    Serial.printf("Temperature: %d°C\n", Temp);
-    Serial.printf("Battery: %d%%\n", Batt);
+    for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+        if (record.mask & (1 << ch)) {
+            Serial.printf("Channel %d moisture: %d%%\n", ch, record.moisture[ch]);
+        }
+    }
+    Serial.printf("Temperature: %d°C\n", record.Temp);
+    Serial.printf("Battery: %d%%\n", record.Batt);
     Serial.printf("Serial Number: %d\n", config.SNr);
     Serial.printf("Sleep interval: %d minutes\n", config.DS_min);
+    Serial.printf("Duty cycle used: %d%%\n", loraHandler->dutyCycleUsage());
+
+    return legacy ? loraHandler->sendData(payload, length)
+                  : loraHandler->sendData(payload, length, ChannelConfig::SAMPLE_PORT);
+}
+
+// Runs in the radio task. Waits out the RX windows after each uplink so the
+// next lmh_send() does not collide with a pending receive.
+void handleTransmitState(const MeasurementRecord& record) {
+    Serial.println("Preparing LoRaWAN transmission...");
+
+    // Samples deferred by the duty cycle budget go out together as one summary
+    bool summary = config.reportEvery > 1 || aggregator.sampleCount() > 1;
+    uint8_t length = summary ? Aggregator::summarySize(aggregator.channelMask()) : sampleSize(record.mask);
+
+    if (!loraHandler->canSend(length)) {
+        Serial.printf("Duty cycle budget low (%lu ms left), deferring %d samples\n",
+                      loraHandler->remainingAirtimeMs(), aggregator.sampleCount());
+        eventQueue.post(EventType::TX_DONE, EventSource::RADIO_TASK, 0);
+        return;
+    }
+
+    for (;;) {
+        bool sent = summary ? transmitSummary(record) : transmitSample(record);
+        vTaskDelay(pdMS_TO_TICKS(TaskConfig::RX_WINDOW_MS));
+
+        if (sent) {
+            Serial.printf("LoRa transmission successful, %lu ms after measurement\n",
+                          millis() - record.timestamp);
+            retryCount = 0;
+            aggregator.reset();
+            eventQueue.post(EventType::TX_DONE, EventSource::RADIO_TASK, 1);
+            break;
+        }
 
-    if (loraHandler->sendData(payload, sizeof(payload))) {
-        Serial.println("LoRa transmission successful");
-        currentState = SystemState::SLEEP;
-    } else {
         Serial.println("LoRa transmission failed");
         if (++retryCount >= SystemConstants::RETRY_COUNT_MAX) {
-            Serial.println("Max retries reached, going to sleep");
+            Serial.println("Max retries reached, dropping samples");
             retryCount = 0;
-            currentState = SystemState::SLEEP;
-        } else {
-            Serial.printf("Retry %d of %d\n", retryCount, SystemConstants::RETRY_COUNT_MAX);
+            aggregator.reset();
+            eventQueue.post(EventType::TX_DONE, EventSource::RADIO_TASK, 0);
+            break;
         }
+        Serial.printf("Retry %d of %d\n", retryCount, SystemConstants::RETRY_COUNT_MAX);
     }
+
+    measurementQueue.printStats();
+    Serial.printf("Stack free: sensor %lu, radio %lu words\n",
+                  uxTaskGetStackHighWaterMark(sensorTaskHandle),
+                  uxTaskGetStackHighWaterMark(radioTaskHandle));
 }
 
 
@@ -406,7 +892,7 @@ void handleSleepState() {
     Serial.printf("\nCycle #%lu, Runtime: %lu seconds\n", cycleCount, runTime);
     
     // Check if we're close to the 55-hour mark where it failed before
-    if (runTime >= 86400) {
+    if (runTime >= SystemConstants::RESET_AFTER_S) {
         Serial.println("WARNING: Approaching previous failure time!  Reset!");
         NVIC_SystemReset();
     }
@@ -416,11 +902,10 @@ void handleSleepState() {
     Serial.println("==================================");
     
     powerManager->enterLowPowerMode();
+    eventQueue.printStats();
+    tempSensor.printStats();
     
-    taskWakeupTimer.stop();
-    Time = SystemConstants::MIN_TO_MS(config.DS_min);
-    taskWakeupTimer.begin(Time, periodicWakeup);
-    taskWakeupTimer.start();
+    armWakeTimer();
     
     PowerMonitor::printPowerStatus("After sleep setup");
     
@@ -474,7 +959,5 @@ void handleSleepState() {
 
 
 void periodicWakeup(TimerHandle_t unused) {
-    eventType = 1;
-    measurementRequested = true;
-    xSemaphoreGiveFromISR(taskEvent, pdFALSE);
+    eventQueue.post(EventType::TIMER_TICK, EventSource::WAKE_TIMER);
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+// processing/aggregator.cpp
+#include "aggregator.h"
+
+void RunningStats::reset() {
+    count = 0;
+    min = max = first = last = 0;
+    mean = m2 = meanK = m2k = cxy = 0;
+}
+
+void RunningStats::add(float value) {
+    float k = count;
+    count++;
+
+    if (count == 1) {
+        min = max = first = value;
+    } else {
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+    last = value;
+
+    float dk = k - meanK;
+    float dx = value - mean;
+    meanK += dk / count;
+    mean += dx / count;
+    m2 += dx * (value - mean);
+    m2k += dk * (k - meanK);
+    cxy += dk * (value - mean);
+}
+
+float RunningStats::variance() const {
+    return (count > 1) ? m2 / (count - 1) : 0;
+}
+
+float RunningStats::slope() const {
+    return (m2k > 0) ? cxy / m2k : 0;
+}
+
+Aggregator::Aggregator() {
+    reset();
+}
+
+void Aggregator::reset() {
+    for (uint8_t ch = 0; ch <= TEMP; ch++) {
+        stats[ch].reset();
+    }
+    samples = 0;
+}
+
+void Aggregator::addSample(const int8_t* moisture, uint8_t mask, int temp) {
+    for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+        if (mask & (1 << ch)) {
+            stats[ch].add(moisture[ch]);
+        }
+    }
+    stats[TEMP].add(temp);
+    samples++;
+}
+
+uint8_t Aggregator::channelMask() const {
+    uint8_t mask = 0;
+    for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+        if (stats[ch].count > 0) {
+            mask |= 1 << ch;
+        }
+    }
+    return mask;
+}
+
+uint8_t Aggregator::summarySize(uint8_t mask) {
+    if (mask == ChannelConfig::LEGACY_MASK) {
+        return SUMMARY_SIZE;
+    }
+    uint8_t channels = 1;   // Temperature
+    for (; mask; mask &= mask - 1) {
+        channels++;
+    }
+    return HEADER_SIZE + 1 + channels * CHANNEL_SIZE;
+}
+
+bool Aggregator::reportDue(uint8_t reportEvery) const {
+    return sampleCount() >= (reportEvery > 0 ? reportEvery : 1);
+}
+
+static float clamp(float value, float lo, float hi) {
+    return value < lo ? lo : (value > hi ? hi : value);
+}
+
+static int16_t toFixed100(float value) {
+    return (int16_t)clamp(value * 100, -32768.0f, 32767.0f);
+}
+
+static void putInt16(uint8_t* buf, int16_t value) {
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+}
+
+static void encodeChannel(uint8_t* out, const RunningStats& s) {
+    out[0] = (int8_t)s.min;
+    out[1] = (int8_t)s.max;
+    out[2] = (int8_t)s.first;
+    out[3] = (int8_t)s.last;
+    putInt16(out + 4, toFixed100(s.mean));
+    uint16_t var = (uint16_t)clamp(s.variance() * 100, 0.0f, 65535.0f);
+    out[6] = var & 0xFF;
+    out[7] = (var >> 8) & 0xFF;
+    putInt16(out + 8, toFixed100(s.slope()));
+}
+
+// Frame layout (little endian):
+//   [0] samples  [1] reportEvery  [2] DS_min  [3] Batt  [4..5] SNr
+//   [6] duty cycle budget used in the last hour, percent
+//   HL + HH (port 3): per channel HL, HH, then Temp
+//   otherwise (port 5): [7] channel mask, per set channel lowest first, then Temp
+//   each channel:
+//   [0] min  [1] max  [2] first  [3] last  [4..5] mean x100
+//   [6..7] variance x100 (saturated)  [8..9] slope x100 per sample
+uint8_t Aggregator::encodeSummary(uint8_t* buf, uint8_t size, uint8_t batt, uint16_t snr,
+                                  uint8_t dsMin, uint8_t reportEvery, uint8_t dutyUsed) const {
+    uint8_t mask = channelMask();
+    uint8_t length = summarySize(mask);
+    if (size < length) {
+        return 0;
+    }
+
+    buf[0] = sampleCount() > 255 ? 255 : sampleCount();
+    buf[1] = reportEvery;
+    buf[2] = dsMin;
+    buf[3] = batt;
+    buf[4] = snr & 0xFF;
+    buf[5] = (snr >> 8) & 0xFF;
+    buf[6] = dutyUsed;
+
+    uint8_t* out = buf + HEADER_SIZE;
+    if (mask != ChannelConfig::LEGACY_MASK) {
+        *out++ = mask;
+    }
+    for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+        if (mask & (1 << ch)) {
+            encodeChannel(out, stats[ch]);
+            out += CHANNEL_SIZE;
+        }
+    }
+    encodeChannel(out, stats[TEMP]);
+    return length;
+}
@@ -0,0 +1,62 @@
+// processing/aggregator.h
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include "config.h"
+
+// Streaming statistics for one channel. Mean, variance and the least-squares
+// slope against the sample index are updated with Welford's method, so the
+// memory use does not depend on the number of samples.
+struct RunningStats {
+    uint16_t count;
+    float min;
+    float max;
+    float first;
+    float last;
+    float mean;
+    float m2;       // Sum of squared deviations from the mean
+    float meanK;    // Mean sample index
+    float m2k;      // Sum of squared deviations of the sample index
+    float cxy;      // Co-moment of sample index and value
+
+    void reset();
+    void add(float value);
+    float variance() const;
+    float slope() const;  // Units per sample
+};
+
+// Statistics per probe channel plus temperature. Channels with a rate
+// divider above 1 simply collect fewer samples.
+class Aggregator {
+public:
+    Aggregator();
+    void reset();
+
+    // moisture[ch] is used for every channel set in mask
+    void addSample(const int8_t* moisture, uint8_t mask, int temp);
+    uint16_t sampleCount() const { return samples; }
+    bool reportDue(uint8_t reportEvery) const;
+    uint8_t channelMask() const;    // Channels with at least one sample
+    const RunningStats& channel(uint8_t ch) const { return stats[ch]; }
+    const RunningStats& temperature() const { return stats[TEMP]; }
+
+    // Summary frame length for a channel mask; HL + HH alone use the
+    // original layout without the mask byte
+    static uint8_t summarySize(uint8_t mask);
+
+    // Writes the summary frame, returns its length or 0 if buf is too small
+    uint8_t encodeSummary(uint8_t* buf, uint8_t size, uint8_t batt, uint16_t snr,
+                          uint8_t dsMin, uint8_t reportEvery, uint8_t dutyUsed) const;
+
+    static constexpr uint8_t TEMP = ChannelConfig::MAX_CHANNELS;
+    static constexpr uint8_t HEADER_SIZE = 7;
+    static constexpr uint8_t CHANNEL_SIZE = 10;
+    static constexpr uint8_t SUMMARY_SIZE = HEADER_SIZE + 3 * CHANNEL_SIZE;     // HL, HH, Temp
+    static constexpr uint8_t MAX_SUMMARY_SIZE = HEADER_SIZE + 1 + (ChannelConfig::MAX_CHANNELS + 1) * CHANNEL_SIZE;
+
+private:
+    RunningStats stats[ChannelConfig::MAX_CHANNELS + 1];
+    uint16_t samples;
+};
+
+#endif // AGGREGATOR_H
@@ -0,0 +1,30 @@
+// communication/airtime.cpp
+#include "airtime.h"
+
+uint8_t Airtime::spreadingFactor(uint8_t dr) {
+    static const uint8_t SF[MAX_DR + 1] = { 12, 11, 10, 9, 8, 7, 7 };
+    return SF[dr <= MAX_DR ? dr : MAX_DR];
+}
+
+uint32_t Airtime::bandwidth(uint8_t dr) {
+    return (dr == 6) ? 250000 : 125000;
+}
+
+uint32_t Airtime::timeOnAirUs(uint8_t dr, uint8_t appPayload) {
+    int32_t sf = spreadingFactor(dr);
+    uint32_t bw = bandwidth(dr);
+    int32_t de = (sf >= 11 && bw == 125000) ? 1 : 0;
+    int32_t pl = appPayload + LORAWAN_OVERHEAD;
+
+    uint32_t symbolUs = (1000000UL << sf) / bw;
+    int32_t num = 8 * pl - 4 * sf + 28 + 16;
+    int32_t den = 4 * (sf - 2 * de);
+    int32_t payloadSymbols = 8;
+    if (num > 0) {
+        payloadSymbols += ((num + den - 1) / den) * (CODING_RATE + 4);
+    }
+
+    // Preamble is PREAMBLE_SYMBOLS + 4.25 symbols
+    uint32_t preambleUs = (PREAMBLE_SYMBOLS * 4 + 17) * symbolUs / 4;
+    return preambleUs + payloadSymbols * symbolUs;
+}
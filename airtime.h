@@ -0,0 +1,23 @@
+// communication/airtime.h
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+
+// LoRa time-on-air for EU868 data rates (Semtech AN1200.13): explicit
+// header, CRC on, coding rate 4/5, 8 preamble symbols, low data rate
+// optimisation for SF11/SF12 at 125 kHz.
+namespace Airtime {
+    constexpr uint8_t LORAWAN_OVERHEAD = 13;    // MHDR, FHDR without FOpts, FPort, MIC
+    constexpr uint8_t PREAMBLE_SYMBOLS = 8;
+    constexpr uint8_t CODING_RATE = 1;          // 4/5
+    constexpr uint8_t MAX_DR = 6;
+
+    uint8_t spreadingFactor(uint8_t dr);
+    uint32_t bandwidth(uint8_t dr);
+
+    // Time on air of an uplink carrying appPayload bytes of application data
+    uint32_t timeOnAirUs(uint8_t dr, uint8_t appPayload);
+}
+
+#endif // AIRTIME_H
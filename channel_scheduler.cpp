@@ -0,0 +1,46 @@
+// sensors/channel_scheduler.cpp
+#include "channel_scheduler.h"
+
+bool ChannelScheduler::isDue(const ProbeChannel& channel, uint32_t cycle) {
+    return channel.rateDivider <= 1 || cycle % channel.rateDivider == 0;
+}
+
+uint8_t ChannelScheduler::switchCost(uint8_t fromMux, uint8_t toMux) {
+    uint8_t diff = (fromMux ^ toMux) & ChannelConfig::MUX_MASK;
+    uint8_t cost = 0;
+    for (; diff; diff &= diff - 1) {
+        cost++;
+    }
+    return cost;
+}
+
+// Greedy nearest neighbour; with at most MAX_CHANNELS entries this is exact
+// enough and ties keep the table order
+uint8_t ChannelScheduler::plan(const ProbeChannel* channels, uint8_t count, uint32_t cycle,
+                               uint8_t currentMux, uint8_t* order) {
+    uint8_t pending = 0;
+    for (uint8_t ch = 0; ch < count && ch < ChannelConfig::MAX_CHANNELS; ch++) {
+        if (isDue(channels[ch], cycle)) {
+            pending |= 1 << ch;
+        }
+    }
+
+    uint8_t planned = 0;
+    uint8_t mux = currentMux;
+    while (pending) {
+        uint8_t best = 0;
+        uint8_t bestCost = 0xFF;
+        for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+            if (!(pending & (1 << ch))) continue;
+            uint8_t cost = switchCost(mux, channels[ch].mux);
+            if (cost < bestCost) {
+                best = ch;
+                bestCost = cost;
+            }
+        }
+        order[planned++] = best;
+        pending &= ~(1 << best);
+        mux = channels[best].mux;
+    }
+    return planned;
+}
@@ -0,0 +1,22 @@
+// sensors/channel_scheduler.h
+#ifndef CHANNEL_SCHEDULER_H
+#define CHANNEL_SCHEDULER_H
+
+#include "config.h"
+
+// Picks the probe channels due in a measurement cycle and orders them so
+// consecutive channels differ in as few PCA9536 lines as possible. Every
+// line change costs a settle delay before the next AD5933 sweep.
+namespace ChannelScheduler {
+    bool isDue(const ProbeChannel& channel, uint32_t cycle);
+
+    // Number of mux lines toggled going from one state to another
+    uint8_t switchCost(uint8_t fromMux, uint8_t toMux);
+
+    // Writes the due channels to order, nearest mux state first starting
+    // from currentMux, and returns how many there are
+    uint8_t plan(const ProbeChannel* channels, uint8_t count, uint32_t cycle,
+                 uint8_t currentMux, uint8_t* order);
+}
+
+#endif // CHANNEL_SCHEDULER_H
@@ -2,6 +2,7 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
 
 // Pin Definitions
@@ -12,7 +13,12 @@ namespace Pins {
     constexpr uint8_t BATT = WB_A0;
     constexpr uint8_t C_SEL = 0;
     constexpr uint8_t EN_SEL = 1;
+    constexpr uint8_t PROBE_SEL0 = 2;   // Probe address, extra channels
+    constexpr uint8_t PROBE_SEL1 = 3;
 }
+#else
+#include <stdint.h>     // Host builds (trace replay) only use the constants below
+#endif
 
 // Battery Configuration
 namespace BatteryConfig {
@@ -27,7 +33,9 @@ namespace BatteryConfig {
 // System Constants
 namespace SystemConstants {
     constexpr uint8_t RETRY_COUNT_MAX = 3;
-    constexpr uint32_t MIN_TO_MS(uint32_t minutes) { return minutes * 30 * 1000; }
+    constexpr uint8_t DEFAULT_DS_MIN = 15;     // Used when the EEPROM holds 0
+    constexpr uint32_t RESET_AFTER_S = 86400;  // Daily reset, clears everything held in RAM
+    constexpr uint32_t MIN_TO_MS(uint32_t minutes) { return minutes * 60 * 1000; }
 }
 
 
@@ -44,26 +52,127 @@ namespace EEPROMConfig {
     constexpr uint16_t CMIN_H_ADDR = 50;
     constexpr uint16_t SNR_ADDR = 60;
     constexpr uint16_t SLEEP_TIME_ADDR = 70;
+    constexpr uint16_t REPORT_EVERY_ADDR = 80;
+    constexpr uint16_t CHANNEL_RATE_ADDR = 84;      // One divider per channel
+    constexpr uint16_t CHANNEL_COUNT_ADDR = 90;
+    constexpr uint16_t CHANNEL_BASE_ADDR = 96;      // Channels 2+: gain, Cmin, Cmax, mux
+    constexpr uint16_t CHANNEL_STRIDE = 16;
+}
+
+// Probe Channel Configuration
+// Channels 0 and 1 are the low and high range of the first probe (HL, HH)
+// and keep their original EEPROM addresses and uplink frames. Further
+// channels select other probes through the PCA9536 PROBE_SEL lines.
+namespace ChannelConfig {
+    constexpr uint8_t MAX_CHANNELS = 4;         // Largest summary stays within the LoRa buffer
+    constexpr uint8_t DEFAULT_COUNT = 2;
+    constexpr uint8_t LEGACY_MASK = 0x03;       // HL + HH, sent in the original frames
+    constexpr uint8_t MUX_MASK = 0x0D;          // C_SEL, PROBE_SEL0, PROBE_SEL1; EN_SEL untouched
+    constexpr uint8_t SAMPLE_PORT = 4;
+    constexpr uint8_t SUMMARY_PORT = 5;
+    constexpr uint32_t SETTLE_MS = 10;          // After any PCA9536 line changes
+}
+
+// Nodes in the field hold their calibration at these addresses; moving one
+// orphans it. Checked here so host tools catch it too.
+static_assert(EEPROMConfig::GAIN_L_ADDR == 0 && EEPROMConfig::GAIN_H_ADDR == 10 &&
+              EEPROMConfig::CMAX_L_ADDR == 20 && EEPROMConfig::CMAX_H_ADDR == 30 &&
+              EEPROMConfig::CMIN_L_ADDR == 40 && EEPROMConfig::CMIN_H_ADDR == 50 &&
+              EEPROMConfig::SNR_ADDR == 60 && EEPROMConfig::SLEEP_TIME_ADDR == 70 &&
+              EEPROMConfig::REPORT_EVERY_ADDR == 80, "Legacy EEPROM addresses moved");
+static_assert(EEPROMConfig::GAIN_H_ADDR - EEPROMConfig::GAIN_L_ADDR >= sizeof(double),
+              "Gain entries overlap");
+static_assert(EEPROMConfig::CHANNEL_RATE_ADDR > EEPROMConfig::REPORT_EVERY_ADDR &&
+              EEPROMConfig::CHANNEL_RATE_ADDR + ChannelConfig::MAX_CHANNELS <= EEPROMConfig::CHANNEL_COUNT_ADDR &&
+              EEPROMConfig::CHANNEL_COUNT_ADDR < EEPROMConfig::CHANNEL_BASE_ADDR,
+              "Channel table overlaps other EEPROM fields");
+static_assert(13 <= EEPROMConfig::CHANNEL_STRIDE, "Channel entry (gain, Cmin, Cmax, mux) exceeds its stride");
+static_assert(EEPROMConfig::CHANNEL_BASE_ADDR + (ChannelConfig::MAX_CHANNELS - 2) * EEPROMConfig::CHANNEL_STRIDE <=
+              EEPROMConfig::EEPROM_SIZE * 128,
+              "Channel table exceeds the 24xx02");
+
+// Aggregation Configuration
+namespace AggregationConfig {
+    constexpr uint8_t DEFAULT_REPORT_EVERY = 1;   // 1 = one uplink per measurement
+    constexpr uint8_t MAX_REPORT_EVERY = 96;
+    constexpr uint8_t SUMMARY_PORT = 3;
+}
+
+// Latency Mode Configuration
+// Downlink 0x06 opens a bounded window of Class C reception or empty
+// uplinks that each open RX1/RX2, then the node falls back to Class A.
+namespace LatencyConfig {
+    constexpr uint8_t MAX_WINDOW_MIN = 30;
+    constexpr uint32_t DAILY_BUDGET_MAS = 20000;    // ~5.6 mAh per 24 h across all windows
+    constexpr uint32_t RX_CURRENT_UA = 5300;        // SX1262 continuous receive
+    constexpr uint32_t TX_CURRENT_UA = 45000;       // SX1262 at 14 dBm
+    constexpr uint32_t RX_WINDOWS_MS = 100;         // Receiver on time for RX1 + RX2 without a downlink
+    constexpr uint32_t BURST_INTERVAL_MS = 30000;   // Empty uplink period in burst mode
+    constexpr uint32_t CLASS_RETRY_MS = 10000;      // Class A request retry after a Class C window
+}
+
+// Task Configuration (stack sizes in 32-bit words)
+namespace TaskConfig {
+    constexpr uint16_t SENSOR_STACK = 1024;
+    constexpr uint16_t RADIO_STACK = 1024;
+    constexpr uint8_t SENSOR_PRIORITY = 1;      // TASK_PRIO_LOW, same as loop()
+    constexpr uint8_t RADIO_PRIORITY = 2;       // TASK_PRIO_NORMAL
+    constexpr uint8_t QUEUE_DEPTH = 16;
+    constexpr uint8_t EVENT_QUEUE_DEPTH = 16;  // Power of two
+    constexpr uint32_t RX_WINDOW_MS = 2500;     // RX1 + RX2 after each uplink
+    constexpr uint32_t JOIN_POLL_MS = 5000;
+}
+
+// Memory Configuration
+// With SMX_STATIC_ALLOC set, subsystem objects, task stacks and queue
+// storage are placed statically and the application never calls new.
+#ifndef SMX_STATIC_ALLOC
+#define SMX_STATIC_ALLOC 1
+#endif
+
+// Per-subsystem budgets in bytes. RAM is checked against sizeof() at compile
+// time in the sketch; RAM and flash are checked against the linked ELF by
+// extras/footprint.
+namespace MemoryBudget {
+    constexpr uint32_t SENSOR_RAM = 6144;       // Sensor task stack and drivers
+    constexpr uint32_t RADIO_RAM = 6144;        // Radio task stack, LoRaWAN handler, aggregator
+    constexpr uint32_t TASKS_RAM = 1536;        // Queues and wake scheduler
+    constexpr uint32_t STORAGE_RAM = 256;
+    constexpr uint32_t SENSOR_FLASH = 24576;
+    constexpr uint32_t RADIO_FLASH = 16384;
+    constexpr uint32_t TASKS_FLASH = 16384;     // Includes the sketch
+    constexpr uint32_t STORAGE_FLASH = 4096;
+}
+
+// Trace Configuration
+namespace TraceConfig {
+    constexpr bool ENABLED = false;     // Print raw sensor traces (TRC lines) to Serial
 }
 
 // System States
+// Sensor task states; transmission runs in the radio task
 enum class SystemState {
     INIT,
     MEASUREMENT,
-    TRANSMIT,
     SLEEP
 };
 
+// One probe channel: mux state plus its calibration
+struct ProbeChannel {
+    double gain;
+    uint16_t Cmin;
+    uint16_t Cmax;
+    uint8_t mux;            // PCA9536 line levels, bit n = IO n
+    uint8_t rateDivider;    // Measured every Nth cycle, 1 = every cycle
+};
+
 // Sensor Configuration
 struct SensorConfig {
-    double gainL;
-    double gainH;
-    uint16_t CminL;
-    uint16_t CmaxL;
-    uint16_t CminH;
-    uint16_t CmaxH;
+    ProbeChannel channels[ChannelConfig::MAX_CHANNELS];
+    uint8_t channelCount;
     uint16_t SNr;
     uint8_t DS_min;
+    uint8_t reportEvery;    // Measurements per summary uplink
 };
 
 #endif // CONFIG_H
\ No newline at end of file
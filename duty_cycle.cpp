@@ -0,0 +1,70 @@
+// communication/duty_cycle.cpp
+#include "duty_cycle.h"
+
+DutyCycleBudget::DutyCycleBudget() {
+    reset();
+}
+
+void DutyCycleBudget::reset() {
+    for (uint8_t slot = 0; slot < SLOTS; slot++) {
+        slotEpoch[slot] = 0;
+        for (uint8_t band = 0; band < BAND_COUNT; band++) {
+            slotMs[band][slot] = 0;
+        }
+    }
+}
+
+DutyCycleBudget::SubBand DutyCycleBudget::subBandFor(uint32_t freqHz) {
+    if (freqHz >= 868700000UL && freqHz <= 869200000UL) return BAND_G1;
+    if (freqHz >= 869400000UL && freqHz <= 869650000UL) return BAND_G2;
+    if (freqHz >= 869700000UL && freqHz <= 870000000UL) return BAND_G3;
+    return BAND_G;
+}
+
+uint32_t DutyCycleBudget::limitMs(SubBand band) {
+    switch (band) {
+        case BAND_G1: return WINDOW_MS / 1000;      // 0.1 %
+        case BAND_G2: return WINDOW_MS / 10;        // 10 %
+        default:      return WINDOW_MS / 100;       // 1 %
+    }
+}
+
+void DutyCycleBudget::record(SubBand band, uint32_t nowMs, uint32_t airtimeMs) {
+    uint32_t epoch = nowMs / BUCKET_MS;
+    uint8_t slot = epoch % SLOTS;
+
+    if (slotEpoch[slot] != epoch) {
+        slotEpoch[slot] = epoch;
+        for (uint8_t b = 0; b < BAND_COUNT; b++) {
+            slotMs[b][slot] = 0;
+        }
+    }
+    slotMs[band][slot] += airtimeMs;
+}
+
+uint32_t DutyCycleBudget::usedMs(SubBand band, uint32_t nowMs) const {
+    uint32_t epoch = nowMs / BUCKET_MS;
+    uint32_t used = 0;
+
+    for (uint8_t slot = 0; slot < SLOTS; slot++) {
+        if (epoch - slotEpoch[slot] < SLOTS) {
+            used += slotMs[band][slot];
+        }
+    }
+    return used;
+}
+
+uint32_t DutyCycleBudget::remainingMs(SubBand band, uint32_t nowMs) const {
+    uint32_t used = usedMs(band, nowMs);
+    uint32_t limit = limitMs(band);
+    return (used < limit) ? limit - used : 0;
+}
+
+bool DutyCycleBudget::canSend(SubBand band, uint32_t nowMs, uint32_t airtimeMs) const {
+    return airtimeMs <= remainingMs(band, nowMs);
+}
+
+uint8_t DutyCycleBudget::usagePercent(SubBand band, uint32_t nowMs) const {
+    uint32_t percent = usedMs(band, nowMs) * 100 / limitMs(band);
+    return percent > 255 ? 255 : percent;
+}
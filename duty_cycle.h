@@ -0,0 +1,44 @@
+// communication/duty_cycle.h
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <stdint.h>
+
+// Sliding one-hour time-on-air budget per EU868 sub-band (ETSI EN 300 220).
+// Airtime is summed into 5-minute buckets; the current bucket and the 12
+// before it are counted, so the window is never shorter than one hour and
+// the budget errs on the safe side.
+class DutyCycleBudget {
+public:
+    enum SubBand : uint8_t {
+        BAND_G,     // 868.0 - 868.6 MHz, 1 % (default uplink channels)
+        BAND_G1,    // 868.7 - 869.2 MHz, 0.1 %
+        BAND_G2,    // 869.4 - 869.65 MHz, 10 %
+        BAND_G3,    // 869.7 - 870.0 MHz, 1 %
+        BAND_COUNT
+    };
+
+    DutyCycleBudget();
+    void reset();
+
+    static SubBand subBandFor(uint32_t freqHz);
+    static uint32_t limitMs(SubBand band);      // Allowed airtime per hour
+
+    void record(SubBand band, uint32_t nowMs, uint32_t airtimeMs);
+    uint32_t usedMs(SubBand band, uint32_t nowMs) const;
+    uint32_t remainingMs(SubBand band, uint32_t nowMs) const;
+    bool canSend(SubBand band, uint32_t nowMs, uint32_t airtimeMs) const;
+    uint8_t usagePercent(SubBand band, uint32_t nowMs) const;   // Saturates at 255
+
+    static constexpr uint32_t WINDOW_MS = 3600000UL;
+    static constexpr uint8_t BUCKETS = 12;
+    static constexpr uint32_t BUCKET_MS = WINDOW_MS / BUCKETS;
+
+private:
+    static constexpr uint8_t SLOTS = BUCKETS + 1;
+
+    uint32_t slotEpoch[SLOTS];
+    uint32_t slotMs[BAND_COUNT][SLOTS];
+};
+
+#endif // DUTY_CYCLE_H
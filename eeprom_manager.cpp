@@ -7,31 +7,61 @@ EEPROMManager::EEPROMManager(ExternalEEPROM& eeprom) : eeprom(eeprom) {}
 bool EEPROMManager::readConfig(SensorConfig& config) {
     Serial.println("Starting EEPROM read process...");
     
+    ProbeChannel& low = config.channels[0];
+    ProbeChannel& high = config.channels[1];
+    
     Serial.println("Reading gainL...");
-    eeprom.get(EEPROMConfig::GAIN_L_ADDR, config.gainL);
+    eeprom.get(EEPROMConfig::GAIN_L_ADDR, low.gain);
     Serial.print("gainL: ");
-    Serial.println(config.gainL, 15);
+    Serial.println(low.gain, 15);
     
     Serial.println("Reading gainH...");
-    eeprom.get(EEPROMConfig::GAIN_H_ADDR, config.gainH);
+    eeprom.get(EEPROMConfig::GAIN_H_ADDR, high.gain);
     Serial.print("gainH: ");
-    Serial.println(config.gainH, 15);
+    Serial.println(high.gain, 15);
     
     Serial.println("Reading CmaxL...");
-    eeprom.get(EEPROMConfig::CMAX_L_ADDR, config.CmaxL);
-    Serial.printf("CmaxL: %d\n", config.CmaxL);
+    eeprom.get(EEPROMConfig::CMAX_L_ADDR, low.Cmax);
+    Serial.printf("CmaxL: %d\n", low.Cmax);
     
     Serial.println("Reading CmaxH...");
-    eeprom.get(EEPROMConfig::CMAX_H_ADDR, config.CmaxH);
-    Serial.printf("CmaxH: %d\n", config.CmaxH);
+    eeprom.get(EEPROMConfig::CMAX_H_ADDR, high.Cmax);
+    Serial.printf("CmaxH: %d\n", high.Cmax);
     
     Serial.println("Reading CminL...");
-    eeprom.get(EEPROMConfig::CMIN_L_ADDR, config.CminL);
-    Serial.printf("CminL: %d\n", config.CminL);
+    eeprom.get(EEPROMConfig::CMIN_L_ADDR, low.Cmin);
+    Serial.printf("CminL: %d\n", low.Cmin);
     
     Serial.println("Reading CminH...");
-    eeprom.get(EEPROMConfig::CMIN_H_ADDR, config.CminH);
-    Serial.printf("CminH: %d\n", config.CminH);
+    eeprom.get(EEPROMConfig::CMIN_H_ADDR, high.Cmin);
+    Serial.printf("CminH: %d\n", high.Cmin);
+    
+    low.mux = 1 << Pins::C_SEL;     // C_SEL high selects the low range
+    high.mux = 0;
+    
+    Serial.println("Reading channels...");
+    config.channelCount = eeprom.read(EEPROMConfig::CHANNEL_COUNT_ADDR);
+    if (config.channelCount == 0 || config.channelCount > ChannelConfig::MAX_CHANNELS) {
+        config.channelCount = ChannelConfig::DEFAULT_COUNT;
+    }
+    for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+        ProbeChannel& channel = config.channels[ch];
+        if (ch >= 2) {
+            uint16_t addr = EEPROMConfig::CHANNEL_BASE_ADDR + (ch - 2) * EEPROMConfig::CHANNEL_STRIDE;
+            eeprom.get(addr, channel.gain);
+            eeprom.get(addr + 8, channel.Cmin);
+            eeprom.get(addr + 10, channel.Cmax);
+            channel.mux = eeprom.read(addr + 12) & ChannelConfig::MUX_MASK;
+        }
+        channel.rateDivider = eeprom.read(EEPROMConfig::CHANNEL_RATE_ADDR + ch);
+        if (channel.rateDivider == 0 || channel.rateDivider == 0xFF) {
+            channel.rateDivider = 1;
+        }
+        if (ch < config.channelCount) {
+            Serial.printf("Channel %d: mux 0x%X, Cmin %d, Cmax %d, every %d cycles\n", ch,
+                          channel.mux, channel.Cmin, channel.Cmax, channel.rateDivider);
+        }
+    }
     
     Serial.println("Reading SNr...");
     eeprom.get(EEPROMConfig::SNR_ADDR, config.SNr);
@@ -39,8 +69,18 @@ bool EEPROMManager::readConfig(SensorConfig& config) {
     
     Serial.println("Reading DS_min...");
     config.DS_min = eeprom.read(EEPROMConfig::SLEEP_TIME_ADDR);
+    if (config.DS_min == 0) {
+        config.DS_min = SystemConstants::DEFAULT_DS_MIN;
+    }
     Serial.printf("DS_min: %d\n", config.DS_min);
     
+    Serial.println("Reading reportEvery...");
+    config.reportEvery = eeprom.read(EEPROMConfig::REPORT_EVERY_ADDR);
+    if (config.reportEvery == 0 || config.reportEvery > AggregationConfig::MAX_REPORT_EVERY) {
+        config.reportEvery = AggregationConfig::DEFAULT_REPORT_EVERY;
+    }
+    Serial.printf("reportEvery: %d\n", config.reportEvery);
+    
     Serial.println("EEPROM read complete");
     return true;
 }
@@ -160,14 +200,19 @@ bool EEPROMManager::writeConfig(const SensorConfig& config) {
     Serial.println("Writing to EEPROM...");
     eeprom.write(EEPROMConfig::SLEEP_TIME_ADDR, (uint8_t)newDS);
     delay(10);  // Wait for write to complete
+    eeprom.write(EEPROMConfig::REPORT_EVERY_ADDR, config.reportEvery);
+    delay(10);
     
     // Read back verification
     uint8_t readBack = eeprom.read(EEPROMConfig::SLEEP_TIME_ADDR);
+    uint8_t reportBack = eeprom.read(EEPROMConfig::REPORT_EVERY_ADDR);
     Serial.print("Verification - Read back value: ");
-    Serial.println(readBack);
+    Serial.print(readBack);
+    Serial.print(", reportEvery: ");
+    Serial.println(reportBack);
     
     // Consider write successful if readback matches
-    bool success = (readBack == (uint8_t)newDS);
+    bool success = (readBack == (uint8_t)newDS) && (reportBack == config.reportEvery);
     Serial.print("Write ");
     Serial.println(success ? "successful!" : "failed!");
     
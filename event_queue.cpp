@@ -0,0 +1,95 @@
+// tasks/event_queue.cpp
+#include "event_queue.h"
+
+static TickType_t currentTick() {
+    return isInISR() ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+}
+
+EventQueue::EventQueue() : enqueuePos(0), dequeuePos(0), consumer(nullptr), posted(0), dropped(0) {
+    for (uint8_t i = 0; i < CAPACITY; i++) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    memset(stats, 0, sizeof(stats));
+}
+
+bool EventQueue::post(EventType type, EventSource source, uint8_t arg, uint32_t value) {
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+
+    // Claim a slot; a producer that loses the race retries with the new head
+    for (;;) {
+        cell = &cells[pos & MASK];
+        uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->event.type = type;
+    cell->event.source = source;
+    cell->event.arg = arg;
+    cell->event.value = value;
+    cell->event.timestamp = currentTick();
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    posted.fetch_add(1, std::memory_order_relaxed);
+
+    // Notify after publishing, so the consumer cannot miss the event
+    if (consumer) {
+        if (isInISR()) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(consumer, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            xTaskNotifyGive(consumer);
+        }
+    }
+    return true;
+}
+
+bool EventQueue::pop(Event& event) {
+    Cell* cell = &cells[dequeuePos & MASK];
+    uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+
+    if ((int32_t)(seq - (dequeuePos + 1)) < 0) {
+        return false;
+    }
+
+    event = cell->event;
+    cell->sequence.store(dequeuePos + CAPACITY, std::memory_order_release);
+    dequeuePos++;
+
+    EventStats& s = stats[(uint8_t)event.type];
+    uint32_t latency = xTaskGetTickCount() - event.timestamp;
+    s.dispatched++;
+    s.latencySumTicks += latency;
+    if (latency > s.latencyMaxTicks) s.latencyMaxTicks = latency;
+    return true;
+}
+
+void EventQueue::wait(Event& event) {
+    while (!pop(event)) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void EventQueue::printStats() const {
+    static const char* NAMES[] = { "timer", "downlink", "join", "tx_done", "sensor_ready", "class", "latency" };
+
+    Serial.printf("Events: posted %lu, dropped %lu\n",
+                  posted.load(std::memory_order_relaxed), dropped.load(std::memory_order_relaxed));
+    for (uint8_t i = 0; i < (uint8_t)EventType::COUNT; i++) {
+        const EventStats& s = stats[i];
+        if (s.dispatched == 0) continue;
+        Serial.printf("  %s: %lu, latency avg %lu ms, max %lu ms\n", NAMES[i], s.dispatched,
+                      s.latencySumTicks * 1000 / configTICK_RATE_HZ / s.dispatched,
+                      s.latencyMaxTicks * 1000 / configTICK_RATE_HZ);
+    }
+}
@@ -0,0 +1,75 @@
+// tasks/event_queue.h
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include "main.h"
+#include <atomic>
+
+enum class EventType : uint8_t {
+    TIMER_TICK,         // Periodic wake timer expired
+    DOWNLINK_COMMAND,   // arg: command byte
+    JOIN_RESULT,        // arg: 1 joined, 0 failed
+    TX_DONE,            // arg: 1 sent, 0 failed or deferred
+    SENSOR_READY,       // arg: records waiting for the radio
+    CLASS_CHANGED,      // arg: DeviceClass_t, value: 1 confirmed by the MAC, 0 refused
+    LATENCY_TICK,       // Latency window timer expired
+    COUNT
+};
+
+enum class EventSource : uint8_t {
+    WAKE_TIMER,
+    LORA_RX,
+    LORA_MAC,
+    RADIO_TASK,
+    SENSOR_TASK,
+    LATENCY_TIMER
+};
+
+struct Event {
+    EventType type;
+    EventSource source;
+    uint8_t arg;
+    uint32_t value;         // Payload that does not fit arg, e.g. sync time
+    TickType_t timestamp;   // Tick count when posted
+};
+
+struct EventStats {
+    uint32_t dispatched;
+    uint32_t latencyMaxTicks;   // Post to dispatch
+    uint32_t latencySumTicks;
+};
+
+// Bounded lock-free ring of typed events (Vyukov's sequence-numbered
+// queue). Any task or ISR may post; a single consumer task waits on its
+// task notification and drains the ring, so simultaneous events are
+// neither merged nor lost.
+class EventQueue {
+public:
+    EventQueue();
+    void setConsumer(TaskHandle_t task) { consumer = task; }
+    bool post(EventType type, EventSource source, uint8_t arg = 0, uint32_t value = 0);
+    bool pop(Event& event);
+    void wait(Event& event);    // Consumer only, blocks until an event arrives
+    void printStats() const;
+
+private:
+    static constexpr uint8_t CAPACITY = TaskConfig::EVENT_QUEUE_DEPTH;
+    static constexpr uint8_t MASK = CAPACITY - 1;
+    static_assert((CAPACITY & MASK) == 0, "Event queue depth must be a power of two");
+
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        Event event;
+    };
+
+    Cell cells[CAPACITY];
+    std::atomic<uint32_t> enqueuePos;
+    uint32_t dequeuePos;
+    TaskHandle_t consumer;
+
+    std::atomic<uint32_t> posted;
+    std::atomic<uint32_t> dropped;
+    EventStats stats[(uint8_t)EventType::COUNT];
+};
+
+#endif // EVENT_QUEUE_H
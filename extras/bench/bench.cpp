@@ -0,0 +1,422 @@
+// extras/bench/bench.cpp
+//
+// Host microbenchmark and golden check for the firmware's hardware-free
+// paths: the ImpedanceMeter::getMoisture chain, temperature compensation,
+// TMP102 and battery conversion, sample, channel and summary frames, and
+// channel planning. Each path runs on fixed inputs, its outputs are compared
+// with golden values and its cost is reported per call as time,
+// allocations and, with -i, user-space instructions from perf_event_open.
+//
+// Build:  make -C extras bench/bench       (make -C extras test also runs it)
+// Usage:  bench [-n iterations] [-b budget_scale] [-i] [-f filter] [-v]
+//
+// Exits with 1 when an output differs from its golden value, a path
+// allocates, or the cost per call exceeds its budget (ns, or instructions
+// with -i; budget_scale multiplies all budgets, 0 disables them).
+//
+// The instruction budgets do not depend on the machine's clock or load,
+// but they are provisional: they were derived by single-stepping the
+// binary, with the same runNothing overhead subtracted as -i does, not
+// with perf_event. Confirm them with -i on a host with a PMU before CI
+// gates on them; until then the test target only gates on time.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <new>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "signal_chain.h"
+#include "payload_codec.h"
+#include "aggregator.h"
+#include "channel_scheduler.h"
+
+// Allocation counting: every path measured here runs on the node, where
+// SMX_STATIC_ALLOC forbids the heap
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+
+// Instruction counter for the calling thread, user space only
+class InstructionCounter {
+public:
+    bool open() {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+        return fd >= 0;
+    }
+    void start() {
+#ifdef __linux__
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    uint64_t stop() {
+        uint64_t count = 0;
+#ifdef __linux__
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+        return count;
+    }
+
+private:
+    int fd = -1;
+};
+
+// Golden inputs, same shape as the node's: NUM_SAMPLES sweeps of NUM_POINTS
+// points at the mid sweep frequency, and 5 battery ADC samples. Not const,
+// so the compiler cannot fold the benchmarked calls.
+constexpr uint8_t SWEEPS = SignalChain::NUM_SAMPLES;
+constexpr uint8_t POINTS = SignalChain::NUM_POINTS;
+constexpr uint8_t BATTERY_SAMPLES = 5;                  // PowerManager::BATTERY_SAMPLES
+
+int16_t sweepReal[SWEEPS][POINTS];
+int16_t sweepImag[SWEEPS][POINTS];
+double gain = 2.2e-8;
+int Cmin = 100;
+int Cmax = 400;
+int16_t tempCounts[] = { 300, 0, -1, 400, -880, 2047 };    // 1/16 C, 13-bit range
+uint16_t batteryRaw[BATTERY_SAMPLES] = { 3000, 3001, 3002, 3003, 3004 };
+float compCapacitance = 187.5f;
+float compTemp = 18.75f;
+int8_t moisture[ChannelConfig::MAX_CHANNELS] = { 42, 57, 13, 99 };
+ProbeChannel channels[ChannelConfig::MAX_CHANNELS] = {
+    { 2.2e-8, 100, 400, 0x01, 1 },
+    { 1.1e-8, 100, 400, 0x00, 1 },
+    { 2.0e-8, 120, 380, 0x05, 2 },
+    { 2.0e-8, 120, 380, 0x0C, 1 },
+};
+Aggregator aggregator;
+
+volatile double sinkReal;
+volatile int sinkInt;
+
+static void initInputs() {
+    for (uint8_t s = 0; s < SWEEPS; s++) {
+        for (uint8_t i = 0; i < POINTS; i++) {
+            sweepReal[s][i] = 1000 + i + s;
+            sweepImag[s][i] = -2000;
+        }
+    }
+    for (uint8_t k = 0; k < 8; k++) {
+        int8_t m[ChannelConfig::MAX_CHANNELS] = { (int8_t)(40 + k), (int8_t)(60 - k), (int8_t)(20 + 2 * k), 90 };
+        aggregator.addSample(m, 0x0F, 18 + (k & 1));
+    }
+}
+
+// One call of each path
+static void runNothing() {
+}
+
+static void runSweepMagnitude() {
+    sinkReal = SignalChain::sweepMagnitude(sweepReal[0], sweepImag[0], POINTS);
+}
+
+// ImpedanceMeter::getMoisture without the AD5933
+static int moistureChain(float tempC, double* impedance, double* capacitance) {
+    SignalChain::SweepSum sweeps;
+    for (uint8_t s = 0; s < SWEEPS; s++) {
+        sweeps.add(SignalChain::sweepMagnitude(sweepReal[s], sweepImag[s], POINTS));
+    }
+    return SignalChain::sweepMoisture(sweeps, gain, Cmin, Cmax, tempC, SignalChain::MID_FREQ,
+                                      impedance, capacitance);
+}
+
+static void runMoistureChain() {
+    double impedance, capacitance;
+    sinkInt = moistureChain(SignalChain::celsius(tempCounts[0]), &impedance, &capacitance);
+}
+
+static void runTempCompensation() {
+    sinkReal = SignalChain::tempCompensation(compCapacitance, compTemp);
+}
+
+static void runTemperature() {
+    sinkInt = SignalChain::temperature(tempCounts[0]);
+    sinkReal = SignalChain::celsius(tempCounts[0]);
+}
+
+static void runBatteryLevel() {
+    sinkReal = SignalChain::batteryLevel(batteryRaw, BATTERY_SAMPLES);
+}
+
+static void runEncodeSample() {
+    uint8_t buf[PayloadCodec::SAMPLE_SIZE];
+    sinkInt = PayloadCodec::encodeSample(buf, sizeof(buf), moisture[0], moisture[1], 19, 87, 60003, 30, 4);
+    sinkInt = buf[3];
+}
+
+static void runEncodeChannels() {
+    uint8_t buf[PayloadCodec::MAX_CHANNELS_SIZE];
+    sinkInt = PayloadCodec::encodeChannels(buf, sizeof(buf), moisture, 0x0B, 19, 87, 60003, 30, 4);
+    sinkInt = buf[3];
+}
+
+static void runEncodeSummary() {
+    uint8_t buf[Aggregator::MAX_SUMMARY_SIZE];
+    sinkInt = aggregator.encodeSummary(buf, sizeof(buf), 87, 60003, 30, 8, 4);
+    sinkInt = buf[10];
+}
+
+static void runChannelPlan() {
+    uint8_t order[ChannelConfig::MAX_CHANNELS];
+    sinkInt = ChannelScheduler::plan(channels, ChannelConfig::MAX_CHANNELS, 6, 0x00, order);
+    sinkInt = order[0];
+}
+
+// Golden checks. The values were taken from the firmware at the time this
+// tool was added; change them only together with an intended change of the
+// node's output.
+static bool verbose = false;
+
+static bool expectInt(const char* what, long actual, long golden) {
+    bool ok = actual == golden;
+    if (!ok || verbose) {
+        printf("  %s %s: %ld, golden %ld\n", ok ? "  " : "!!", what, actual, golden);
+    }
+    return ok;
+}
+
+static bool expectReal(const char* what, double actual, double golden) {
+    bool ok = fabs(actual - golden) <= 1e-5 * fabs(golden);
+    if (!ok || verbose) {
+        printf("  %s %s: %.9g, golden %.9g\n", ok ? "  " : "!!", what, actual, golden);
+    }
+    return ok;
+}
+
+static bool expectBytes(const char* what, const uint8_t* actual, uint8_t length,
+                        const uint8_t* golden, uint8_t goldenLength) {
+    bool ok = length == goldenLength && memcmp(actual, golden, length) == 0;
+    if (!ok || verbose) {
+        printf("  %s %s:", ok ? "  " : "!!", what);
+        for (uint8_t i = 0; i < length; i++) printf(" %02X", actual[i]);
+        printf("\n");
+        if (!ok) {
+            printf("     golden:");
+            for (uint8_t i = 0; i < goldenLength; i++) printf(" %02X", golden[i]);
+            printf("\n");
+        }
+    }
+    return ok;
+}
+
+static bool checkSweepMagnitude() {
+    return expectReal("magnitude", SignalChain::sweepMagnitude(sweepReal[0], sweepImag[0], POINTS), 2241.0095);
+}
+
+static bool checkMoistureChain() {
+    double impedance = 0, capacitance = 0;
+    int result = moistureChain(SignalChain::celsius(tempCounts[0]), &impedance, &capacitance);
+    bool ok = expectReal("impedance", impedance, 20070.8963);
+    ok &= expectReal("capacitance", capacitance, 69.3912735);
+    ok &= expectInt("moisture", result, 10);
+    return ok;
+}
+
+static bool checkTempCompensation() {
+    bool ok = expectReal("compensated", SignalChain::tempCompensation(compCapacitance, compTemp), 164.0625);
+    ok &= expectReal("at reference", SignalChain::tempCompensation(compCapacitance, SignalChain::REF_TEMP),
+                     compCapacitance);
+    return ok;
+}
+
+static bool checkTemperature() {
+    static const int GOLDEN_INT[] = { 19, 0, 0, 25, -55, 128 };      // Nearest, halves away from zero
+    static const float GOLDEN_C[] = { 18.75f, 0, -0.0625f, 25, -55, 127.9375f };
+    bool ok = true;
+    for (uint8_t i = 0; i < sizeof(tempCounts) / sizeof(tempCounts[0]); i++) {
+        char what[32];
+        snprintf(what, sizeof(what), "temperature(%d)", tempCounts[i]);
+        ok &= expectInt(what, SignalChain::temperature(tempCounts[i]), GOLDEN_INT[i]);
+        snprintf(what, sizeof(what), "celsius(%d)", tempCounts[i]);
+        ok &= expectReal(what, SignalChain::celsius(tempCounts[i]), GOLDEN_C[i]);
+    }
+    return ok;
+}
+
+static bool checkBatteryLevel() {
+    static const uint16_t EMPTY[BATTERY_SAMPLES] = { 0, 0, 0, 0, 0 };
+    static const uint16_t FULL[BATTERY_SAMPLES] = { 4095, 4095, 4095, 4095, 4095 };
+    bool ok = expectReal("level", SignalChain::batteryLevel(batteryRaw, BATTERY_SAMPLES), 38.7541122);
+    ok &= expectReal("empty", SignalChain::batteryLevel(EMPTY, BATTERY_SAMPLES), 0);
+    ok &= expectReal("full", SignalChain::batteryLevel(FULL, BATTERY_SAMPLES), 100);
+    return ok;
+}
+
+static bool checkEncodeSample() {
+    static const uint8_t GOLDEN[] = { 0x2A, 0x00, 0x39, 0x00, 0x13, 0x57, 0x63, 0xEA, 0x1E, 0x04 };
+    uint8_t buf[PayloadCodec::SAMPLE_SIZE];
+    uint8_t length = PayloadCodec::encodeSample(buf, sizeof(buf), moisture[0], moisture[1], 19, 87, 60003, 30, 4);
+    bool ok = expectBytes("frame", buf, length, GOLDEN, sizeof(GOLDEN));
+    ok &= expectInt("short buffer", PayloadCodec::encodeSample(buf, PayloadCodec::SAMPLE_SIZE - 1, 0, 0, 0, 0, 0, 0, 0), 0);
+    return ok;
+}
+
+static bool checkEncodeChannels() {
+    static const uint8_t GOLDEN[] = { 0x0B, 0x2A, 0x39, 0x63, 0x13, 0x57, 0x63, 0xEA, 0x1E, 0x04 };
+    uint8_t buf[PayloadCodec::MAX_CHANNELS_SIZE];
+    uint8_t length = PayloadCodec::encodeChannels(buf, sizeof(buf), moisture, 0x0B, 19, 87, 60003, 30, 4);
+    bool ok = expectBytes("frame", buf, length, GOLDEN, sizeof(GOLDEN));
+    ok &= expectInt("size", PayloadCodec::channelsSize(0x0B), sizeof(GOLDEN));
+    return ok;
+}
+
+static bool checkEncodeSummary() {
+    static const uint8_t GOLDEN[] = {
+        0x08, 0x08, 0x1E, 0x57, 0x63, 0xEA, 0x04, 0x0F,
+        0x28, 0x2F, 0x28, 0x2F, 0xFE, 0x10, 0x58, 0x02, 0x64, 0x00,
+        0x35, 0x3C, 0x3C, 0x35, 0x12, 0x16, 0x58, 0x02, 0x9C, 0xFF,
+        0x14, 0x22, 0x14, 0x22, 0x8C, 0x0A, 0x60, 0x09, 0xC8, 0x00,
+        0x5A, 0x5A, 0x5A, 0x5A, 0x28, 0x23, 0x00, 0x00, 0x00, 0x00,
+        0x12, 0x13, 0x12, 0x13, 0x3A, 0x07, 0x1C, 0x00, 0x04, 0x00,
+    };
+    uint8_t buf[Aggregator::MAX_SUMMARY_SIZE];
+    uint8_t length = aggregator.encodeSummary(buf, sizeof(buf), 87, 60003, 30, 8, 4);
+    bool ok = expectBytes("frame", buf, length, GOLDEN, sizeof(GOLDEN));
+    ok &= expectInt("legacy size", Aggregator::summarySize(ChannelConfig::LEGACY_MASK), Aggregator::SUMMARY_SIZE);
+    return ok;
+}
+
+static bool checkChannelPlan() {
+    static const uint8_t GOLDEN[] = { 1, 0, 2, 3 };      // Channel 2 is due on even cycles
+    uint8_t order[ChannelConfig::MAX_CHANNELS];
+    uint8_t planned = ChannelScheduler::plan(channels, ChannelConfig::MAX_CHANNELS, 6, 0x00, order);
+    bool ok = expectBytes("order", order, planned, GOLDEN, sizeof(GOLDEN));
+    ok &= expectInt("odd cycle", ChannelScheduler::plan(channels, ChannelConfig::MAX_CHANNELS, 7, 0x00, order), 3);
+    return ok;
+}
+
+struct Case {
+    const char* name;
+    void (*run)();
+    bool (*check)();
+    double budgetNs;        // Per call, generous for slow CI hosts
+    double budgetInsns;     // Per call, x86-64 at -O2, ~1.5x the count; provisional, see above
+};
+
+static const Case CASES[] = {
+    { "sweep_magnitude",   runSweepMagnitude,   checkSweepMagnitude,   150, 400 },
+    { "moisture_chain",    runMoistureChain,    checkMoistureChain,    1000, 2200 },
+    { "temp_compensation", runTempCompensation, checkTempCompensation, 10, 30 },
+    { "temperature",       runTemperature,      checkTemperature,      25, 95 },
+    { "battery_level",     runBatteryLevel,     checkBatteryLevel,     40, 110 },
+    { "encode_sample",     runEncodeSample,     checkEncodeSample,     30, 100 },
+    { "encode_channels",   runEncodeChannels,   checkEncodeChannels,   50, 160 },
+    { "encode_summary",    runEncodeSummary,    checkEncodeSummary,    350, 750 },
+    { "channel_plan",      runChannelPlan,      checkChannelPlan,      300, 650 },
+};
+
+struct Cost {
+    double ns;
+    double insns;
+    double allocs;
+};
+
+static Cost measure(void (*run)(), unsigned long iterations, InstructionCounter* counter) {
+    Cost cost = {};
+    unsigned long before = allocations;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++) run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    cost.ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    cost.allocs = (double)(allocations - before) / iterations;
+
+    if (counter) {
+        counter->start();
+        for (unsigned long i = 0; i < iterations; i++) run();
+        cost.insns = (double)counter->stop() / iterations;
+    }
+    return cost;
+}
+
+int main(int argc, char** argv) {
+    unsigned long iterations = 200000;
+    double budgetScale = 1;
+    bool countInstructions = false;
+    const char* filter = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) iterations = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) budgetScale = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-i")) countInstructions = true;
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) filter = argv[++i];
+        else if (!strcmp(argv[i], "-v")) verbose = true;
+        else {
+            fprintf(stderr, "usage: %s [-n iterations] [-b budget_scale] [-i] [-f filter] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0) iterations = 1;
+
+    InstructionCounter counter;
+    if (countInstructions && !counter.open()) {
+        fprintf(stderr, "perf_event_open failed, instruction counts unavailable "
+                        "(check /proc/sys/kernel/perf_event_paranoid)\n");
+        return 2;
+    }
+    InstructionCounter* insns = countInstructions ? &counter : nullptr;
+
+    initInputs();
+
+    // Loop and call overhead, subtracted from every case
+    Cost overhead = measure(runNothing, iterations, insns);
+
+    int failures = 0;
+    printf("%-18s %10s %10s %8s %10s  %s\n", "path", "ns/call", "insns", "allocs", "budget", "result");
+    for (const Case& c : CASES) {
+        if (filter && !strstr(c.name, filter)) continue;
+
+        bool golden = c.check();
+        Cost cost = measure(c.run, iterations, insns);
+        cost.ns = fmax(0, cost.ns - overhead.ns);
+        cost.insns = fmax(0, cost.insns - overhead.insns);
+
+        double budget = (countInstructions ? c.budgetInsns : c.budgetNs) * budgetScale;
+        double spent = countInstructions ? cost.insns : cost.ns;
+        bool overBudget = budget > 0 && spent > budget;
+        bool allocates = cost.allocs > 0;
+
+        const char* result = !golden ? "FAIL golden" : allocates ? "FAIL allocates"
+                           : overBudget ? "FAIL budget" : "ok";
+        if (countInstructions) {
+            printf("%-18s %10.1f %10.1f %8.2f %10.0f  %s\n", c.name, cost.ns, cost.insns, cost.allocs, budget, result);
+        } else {
+            printf("%-18s %10.1f %10s %8.2f %10.0f  %s\n", c.name, cost.ns, "-", cost.allocs, budget, result);
+        }
+        if (!golden || allocates || overBudget) failures++;
+    }
+
+    if (failures) {
+        printf("FAIL: %d of the paths above\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,448 @@
+// extras/fleet_sim/fleet_sim.cpp
+//
+// Host-side fleet simulator for SMX nodes sharing one EU868 gateway.
+//
+// Every simulated node runs the firmware's wake/measure/transmit cycle in
+// virtual time: it wakes on its own drifting timer, feeds synthetic readings
+// into the firmware Aggregator, encodes the uplink with PayloadCodec or
+// Aggregator::encodeSummary, and arms its next wake from the firmware
+// WakeScheduler the way handleSleepState() does (-w restart models the
+// old timer restart after each cycle). Like handleTransmitState(), a node defers and
+// batches uplinks that would exceed its DutyCycleBudget. Uplinks go to a channel model with the three
+// default EU868 channels, per-SF collisions with a capture threshold, an
+// 8-path gateway demodulator and a network-server stand-in that checks
+// frame counters.
+//
+// Build:  make -C extras fleet_sim/fleet_sim
+// Usage:  fleet_sim [-n 100,500,1000] [-d days] [-i 15|5,15,60] [-r report_every]
+//                   [-D dr|adr] [-j drift_ppm] [-a awake_ms] [-p power_on_spread_s]
+//                   [-w slot|restart] [-S] [-c channels] [-s seed]
+//
+// -i takes one DS_min for the whole fleet or a list; with a list every
+// node draws its interval from it uniformly, so repeating a value weights it.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "airtime.h"
+#include "aggregator.h"
+#include "duty_cycle.h"
+#include "payload_codec.h"
+#include "wake_scheduler.h"
+
+namespace {
+
+constexpr uint64_t US_PER_MS = 1000;
+constexpr uint64_t US_PER_S = 1000000;
+constexpr uint64_t US_PER_HOUR = 3600 * US_PER_S;
+constexpr uint32_t INITIAL_WAKE_MS = 15000;     // First interval set in initializeSystem()
+constexpr uint8_t CHANNELS = 3;                 // 868.1, 868.3, 868.5 MHz
+constexpr uint8_t DEMODULATORS = 8;
+constexpr double CAPTURE_DB = 6.0;
+constexpr double TX_POWER_DBM = 14.0;
+constexpr double DUTY_LIMIT = 0.01;             // Sub-band g, 1 %
+
+// Log-distance path loss for a rural deployment with a mast-mounted gateway
+constexpr double PL_D0_DB = 120.0;
+constexpr double D0_M = 1000.0;
+constexpr double MIN_DISTANCE_M = 100.0;
+constexpr double PL_EXPONENT = 2.7;
+constexpr double SHADOWING_DB = 4.0;
+
+double sensitivityDbm(uint8_t sf) {
+    static const double SENS[] = { -123.0, -126.0, -129.0, -132.0, -134.5, -137.0 };
+    return SENS[sf - 7];
+}
+
+struct Options {
+    std::vector<unsigned> nodeCounts = { 100, 500, 1000, 2000 };
+    double days = 30;
+    std::vector<uint8_t> intervals = { 15 };    // DS_min per node, drawn uniformly
+    uint8_t reportEvery = AggregationConfig::DEFAULT_REPORT_EVERY;
+    int dr = 3;                 // -1 = pick per node from link budget
+    double driftPpm = 20;
+    uint32_t awakeMs = 1500;
+    double powerOnSpreadS = 60;
+    bool slotted = true;        // Absolute schedule, false = restart after each cycle
+    bool timeSync = false;      // Nodes share the network epoch from power-on
+    uint8_t channels = ChannelConfig::DEFAULT_COUNT;   // Probe channels per node
+    uint64_t seed = 1;
+    double radiusM = 4000;
+};
+
+struct Node {
+    uint8_t dr;
+    uint8_t intervalMin;
+    double clockScale;      // Local timer period / true period
+    uint64_t powerOn;
+    WakeScheduler scheduler;
+    double meanRssi;
+    Aggregator aggregator;
+    DutyCycleBudget budget;
+    uint16_t fcnt = 0;
+    uint32_t uplinks = 0;
+    uint32_t delivered = 0;
+    uint64_t airtimeUs = 0;
+    uint64_t hourStart = 0;
+    uint64_t hourAirtimeUs = 0;
+    uint64_t maxHourAirtimeUs = 0;
+    float moisture[ChannelConfig::MAX_CHANNELS] = { 40, 40, 40, 40 };
+    float temp = 18;
+};
+
+struct Packet {
+    uint32_t node;
+    uint16_t fcnt;
+    uint16_t samples;       // Measurements carried by this frame
+    uint8_t channel;
+    uint8_t sf;
+    uint8_t length;
+    uint64_t start;
+    uint64_t end;
+    double rssi;
+    bool demodulated;
+    bool destroyed;
+};
+
+enum EventType : uint8_t { EV_WAKE, EV_TX };
+
+struct Event {
+    uint64_t time;
+    uint32_t node;
+    EventType type;
+    uint8_t length;
+    uint16_t samples;
+    bool operator>(const Event& o) const { return time > o.time; }
+};
+
+struct Results {
+    uint64_t uplinks = 0, delivered = 0, samples = 0, samplesDelivered = 0;
+    uint64_t lostCollision = 0, lostDemod = 0, lostSensitivity = 0, deferred = 0;
+    uint64_t busyUs = 0, airtimeSumUs = 0;
+    unsigned peakConcurrent = 0;
+    unsigned nodesOverDuty = 0;
+    double maxNodeDuty = 0;
+    uint64_t fcntGaps = 0;
+    uint64_t missedSlots = 0;
+    double wallS = 0;
+};
+
+class Simulator {
+public:
+    Simulator(const Options& opt, unsigned nodeCount)
+        : opt(opt), rng(opt.seed * 7919 + nodeCount), endUs((uint64_t)(opt.days * 24 * US_PER_HOUR)) {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::normal_distribution<double> drift(0.0, opt.driftPpm);
+
+        nodes.resize(nodeCount);
+        lastFcnt.assign(nodeCount, -1);
+        for (uint32_t i = 0; i < nodeCount; i++) {
+            Node& n = nodes[i];
+            double d = std::max(MIN_DISTANCE_M, opt.radiusM * sqrt(unit(rng)));
+            n.meanRssi = TX_POWER_DBM - (PL_D0_DB + 10 * PL_EXPONENT * log10(d / D0_M));
+            n.dr = (opt.dr >= 0) ? opt.dr : adrFor(n.meanRssi);
+            n.clockScale = 1.0 + drift(rng) * 1e-6;
+
+            uint8_t eui[8] = { 0xAC, 0x1F, 0x09, 0xFF, 0xFE, 0x18, (uint8_t)(i >> 8), (uint8_t)i };
+            n.scheduler.setIdentity(eui, sizeof(eui), i);
+            n.powerOn = (uint64_t)(unit(rng) * opt.powerOnSpreadS * US_PER_S);
+            if (opt.timeSync) {
+                n.scheduler.sync(0, n.powerOn / US_PER_MS);
+            }
+            if (opt.intervals.size() > 1) {
+                std::uniform_int_distribution<size_t> pick(0, opt.intervals.size() - 1);
+                n.intervalMin = opt.intervals[pick(rng)];
+            } else {
+                n.intervalMin = opt.intervals[0];
+            }
+            schedule(n.powerOn + localToTrue(n, INITIAL_WAKE_MS * US_PER_MS), i, EV_WAKE, 0, 0);
+        }
+    }
+
+    Results run() {
+        auto wallStart = std::chrono::steady_clock::now();
+        while (!events.empty() && events.top().time < endUs) {
+            Event ev = events.top();
+            events.pop();
+            retire(ev.time);
+            if (ev.type == EV_WAKE) {
+                wake(ev.time, ev.node);
+            } else {
+                transmit(ev.time, ev.node, ev.length, ev.samples);
+            }
+        }
+        retire(UINT64_MAX);
+
+        for (const Node& n : nodes) {
+            double duty = (double)n.maxHourAirtimeUs / US_PER_HOUR;
+            res.maxNodeDuty = std::max(res.maxNodeDuty, duty);
+            if (duty > DUTY_LIMIT) res.nodesOverDuty++;
+            res.missedSlots += n.scheduler.missedSlots();
+        }
+        res.wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        return res;
+    }
+
+private:
+    static uint8_t adrFor(double rssi) {
+        // Fastest DR that keeps a 10 dB margin, like a network server ADR
+        for (int dr = 5; dr > 0; dr--) {
+            if (rssi - 10 >= sensitivityDbm(Airtime::spreadingFactor(dr))) return dr;
+        }
+        return 0;
+    }
+
+    static uint64_t localToTrue(const Node& n, uint64_t localUs) {
+        return (uint64_t)(localUs * n.clockScale);
+    }
+
+    // Node's millis() at true time t
+    static uint32_t localMs(const Node& n, uint64_t t) {
+        return (uint32_t)((t - n.powerOn) / n.clockScale / US_PER_MS);
+    }
+
+    void schedule(uint64_t time, uint32_t node, EventType type, uint8_t length, uint16_t samples) {
+        events.push(Event{ time, node, type, length, samples });
+    }
+
+    // Measurement, aggregation and frame encoding as in handleMeasurementState()
+    // and handleTransmitState(), then the next wake from handleSleepState()
+    void wake(uint64_t now, uint32_t idx) {
+        Node& n = nodes[idx];
+        std::normal_distribution<float> step(0.0f, 0.5f);
+        std::uniform_real_distribution<double> jitter(0.9, 1.1);
+
+        uint8_t mask = (1 << opt.channels) - 1;
+        int8_t moisture[ChannelConfig::MAX_CHANNELS];
+        for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+            n.moisture[ch] = std::min(100.0f, std::max(0.0f, n.moisture[ch] + step(rng)));
+            moisture[ch] = (int8_t)n.moisture[ch];
+        }
+        n.temp += step(rng) * 0.2f;
+        n.aggregator.addSample(moisture, mask, (int)n.temp);
+        res.samples++;
+
+        uint64_t awake = localToTrue(n, (uint64_t)(opt.awakeMs * jitter(rng)) * US_PER_MS);
+        if (n.aggregator.reportDue(opt.reportEvery)) {
+            uint32_t txMs = (uint32_t)((now + awake) / US_PER_MS);
+            bool summary = opt.reportEvery > 1 || n.aggregator.sampleCount() > 1;
+            bool legacy = mask == ChannelConfig::LEGACY_MASK;
+            uint8_t maxLength = summary ? Aggregator::summarySize(mask)
+                                        : legacy ? PayloadCodec::SAMPLE_SIZE : PayloadCodec::channelsSize(mask);
+            uint32_t airtimeMs = (Airtime::timeOnAirUs(n.dr, maxLength) + 999) / 1000;
+
+            if (n.budget.canSend(DutyCycleBudget::BAND_G, txMs, airtimeMs)) {
+                uint8_t duty = n.budget.usagePercent(DutyCycleBudget::BAND_G, txMs);
+                uint8_t frame[Aggregator::MAX_SUMMARY_SIZE];
+                uint8_t length = summary
+                    ? n.aggregator.encodeSummary(frame, sizeof(frame), 80, idx, n.intervalMin,
+                                                 opt.reportEvery, duty)
+                    : legacy
+                    ? PayloadCodec::encodeSample(frame, sizeof(frame), moisture[0], moisture[1],
+                                                 (int)n.temp, 80, idx, n.intervalMin, duty)
+                    : PayloadCodec::encodeChannels(frame, sizeof(frame), moisture, mask,
+                                                   (int)n.temp, 80, idx, n.intervalMin, duty);
+                n.budget.record(DutyCycleBudget::BAND_G, txMs, airtimeMs);
+                schedule(now + awake, idx, EV_TX, length, n.aggregator.sampleCount());
+                n.aggregator.reset();
+            } else {
+                res.deferred++;
+            }
+        }
+
+        uint32_t periodMs = SystemConstants::MIN_TO_MS(n.intervalMin);
+        if (opt.slotted) {
+            uint32_t wakeMs = n.scheduler.nextWake(localMs(n, now + awake), periodMs);
+            schedule(n.powerOn + localToTrue(n, wakeMs * US_PER_MS), idx, EV_WAKE, 0, 0);
+        } else {
+            schedule(now + awake + localToTrue(n, periodMs * US_PER_MS), idx, EV_WAKE, 0, 0);
+        }
+    }
+
+    void transmit(uint64_t now, uint32_t idx, uint8_t length, uint16_t samples) {
+        Node& n = nodes[idx];
+        std::uniform_int_distribution<int> channel(0, CHANNELS - 1);
+        std::normal_distribution<double> shadowing(0.0, SHADOWING_DB);
+
+        Packet p;
+        p.node = idx;
+        p.fcnt = n.fcnt++;
+        p.samples = samples;
+        p.channel = channel(rng);
+        p.sf = Airtime::spreadingFactor(n.dr);
+        p.length = length;
+        p.start = now;
+        p.end = now + Airtime::timeOnAirUs(n.dr, length);
+        p.rssi = n.meanRssi + shadowing(rng);
+        p.destroyed = false;
+
+        unsigned locked = 0;
+        for (Packet& other : inFlight) {
+            if (other.demodulated) locked++;
+            if (other.channel != p.channel || other.sf != p.sf) continue;
+            if (other.rssi - p.rssi < CAPTURE_DB) other.destroyed = true;
+            if (p.rssi - other.rssi < CAPTURE_DB) p.destroyed = true;
+        }
+        bool audible = p.rssi >= sensitivityDbm(p.sf);
+        p.demodulated = audible && locked < DEMODULATORS;
+        if (!audible) res.lostSensitivity++;
+        else if (!p.demodulated) res.lostDemod++;
+
+        uint64_t airtime = p.end - p.start;
+        n.uplinks++;
+        n.airtimeUs += airtime;
+        if (now - n.hourStart >= US_PER_HOUR) {
+            n.hourStart = now;
+            n.hourAirtimeUs = 0;
+        }
+        n.hourAirtimeUs += airtime;
+        n.maxHourAirtimeUs = std::max(n.maxHourAirtimeUs, n.hourAirtimeUs);
+        res.uplinks++;
+        res.airtimeSumUs += airtime;
+
+        accountBusy(now);
+        inFlight.push_back(p);
+        res.peakConcurrent = std::max<unsigned>(res.peakConcurrent, inFlight.size());
+    }
+
+    // Gateway busy time: at least one uplink on air
+    void accountBusy(uint64_t now) {
+        if (!inFlight.empty() && now > busySince) {
+            res.busyUs += now - busySince;
+        }
+        busySince = now;
+    }
+
+    // Delivers every packet that has finished by 'now' to the network server
+    void retire(uint64_t now) {
+        for (size_t i = 0; i < inFlight.size();) {
+            const Packet& p = inFlight[i];
+            if (p.end > now) {
+                i++;
+                continue;
+            }
+            accountBusy(std::min(p.end, endUs));
+            if (p.demodulated && !p.destroyed) {
+                serverReceive(p);
+            } else if (p.demodulated) {
+                res.lostCollision++;
+            }
+            inFlight[i] = inFlight.back();
+            inFlight.pop_back();
+        }
+        if (inFlight.empty()) busySince = now;
+    }
+
+    // Network-server stand-in: frame counter tracking and sample accounting
+    void serverReceive(const Packet& p) {
+        int32_t& last = lastFcnt[p.node];
+        if (last >= 0 && p.fcnt > last + 1) {
+            res.fcntGaps += p.fcnt - last - 1;
+        }
+        last = p.fcnt;
+        nodes[p.node].delivered++;
+        res.delivered++;
+        res.samplesDelivered += p.samples;
+    }
+
+    const Options& opt;
+    std::mt19937_64 rng;
+    uint64_t endUs;
+    std::vector<Node> nodes;
+    std::vector<int32_t> lastFcnt;
+    std::vector<Packet> inFlight;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event> > events;
+    uint64_t busySince = 0;
+    Results res;
+};
+
+bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "-S")) {
+            opt.timeSync = true;
+            continue;
+        }
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!val) return false;
+        if (!strcmp(arg, "-n")) {
+            opt.nodeCounts.clear();
+            for (char* tok = strtok(argv[++i], ","); tok; tok = strtok(nullptr, ",")) {
+                opt.nodeCounts.push_back(strtoul(tok, nullptr, 10));
+            }
+        } else if (!strcmp(arg, "-d")) opt.days = atof(argv[++i]);
+        else if (!strcmp(arg, "-i")) {
+            opt.intervals.clear();
+            for (char* tok = strtok(argv[++i], ","); tok; tok = strtok(nullptr, ",")) {
+                int minutes = atoi(tok);
+                if (minutes <= 0 || minutes > 255) return false;
+                opt.intervals.push_back((uint8_t)minutes);
+            }
+        }
+        else if (!strcmp(arg, "-r")) opt.reportEvery = atoi(argv[++i]);
+        else if (!strcmp(arg, "-D")) { i++; opt.dr = !strcmp(val, "adr") ? -1 : atoi(val); }
+        else if (!strcmp(arg, "-j")) opt.driftPpm = atof(argv[++i]);
+        else if (!strcmp(arg, "-a")) opt.awakeMs = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "-p")) opt.powerOnSpreadS = atof(argv[++i]);
+        else if (!strcmp(arg, "-w")) { i++; opt.slotted = strcmp(val, "restart") != 0; }
+        else if (!strcmp(arg, "-c")) opt.channels = atoi(argv[++i]);
+        else if (!strcmp(arg, "-s")) opt.seed = strtoull(argv[++i], nullptr, 10);
+        else return false;
+    }
+    return !opt.nodeCounts.empty() && !opt.intervals.empty() && opt.reportEvery > 0 && opt.dr <= Airtime::MAX_DR &&
+           opt.channels > 0 && opt.channels <= ChannelConfig::MAX_CHANNELS;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s [-n 100,500,1000] [-d days] [-i 15|5,15,60] [-r report_every]\n"
+                        "       [-D dr|adr] [-j drift_ppm] [-a awake_ms] [-p power_on_spread_s]\n"
+                        "       [-w slot|restart] [-S] [-c channels] [-s seed]\n",
+                argv[0]);
+        return 2;
+    }
+
+    std::string intervals;
+    for (uint8_t minutes : opt.intervals) {
+        intervals += (intervals.empty() ? "" : ",") + std::to_string(minutes);
+    }
+    printf("%.1f days, DS_min %s, report every %u, DR %s, drift %.0f ppm, power-on spread %.0f s\n"
+           "wake schedule: %s%s, %u probe channels\n\n",
+           opt.days, intervals.c_str(), opt.reportEvery,
+           opt.dr < 0 ? "adr" : std::to_string(opt.dr).c_str(), opt.driftPpm, opt.powerOnSpreadS,
+           opt.slotted ? "slot" : "restart", opt.timeSync ? ", time synced" : "", opt.channels);
+    printf("%6s %10s %9s %7s %7s %9s %9s %9s %10s %8s %9s %6s %6s %7s %7s\n",
+           "nodes", "uplinks", "deferred", "PDR", "SDR", "collided", "demod", "too_weak", "air_s/day",
+           "max_dc", "over_1%", "gw_occ", "peak", "missed", "wall_s");
+
+    for (unsigned count : opt.nodeCounts) {
+        Simulator sim(opt, count);
+        Results r = sim.run();
+        double simS = opt.days * 24 * 3600;
+        printf("%6u %10llu %9llu %6.2f%% %6.2f%% %9llu %9llu %9llu %10.2f %7.3f%% %9u %5.1f%% %6u %7llu %7.2f\n",
+               count, (unsigned long long)r.uplinks, (unsigned long long)r.deferred,
+               r.uplinks ? 100.0 * r.delivered / r.uplinks : 0.0,
+               r.samples ? 100.0 * r.samplesDelivered / r.samples : 0.0,
+               (unsigned long long)r.lostCollision, (unsigned long long)r.lostDemod,
+               (unsigned long long)r.lostSensitivity,
+               r.airtimeSumUs / 1e6 / count / opt.days,
+               100.0 * r.maxNodeDuty, r.nodesOverDuty,
+               100.0 * r.busyUs / 1e6 / simS, r.peakConcurrent, (unsigned long long)r.missedSlots, r.wallS);
+    }
+    printf("\nPDR: delivered/sent uplinks, SDR: delivered/taken samples, max_dc: worst node duty cycle\n"
+           "in any clock hour, gw_occ: share of time with at least one uplink on air,\n"
+           "missed: wake slots skipped because a cycle overran its period.\n");
+    return 0;
+}
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# extras/footprint/footprint.py
+#
+# RAM/flash footprint of an SMX firmware image, broken down per subsystem
+# and checked against the MemoryBudget namespace in config.h.
+#
+# Usage:  footprint.py [-c ../../config.h] [--nm arm-none-eabi-nm] SMX_v0_3_SPARK.ino.elf
+#
+# Symbols are assigned to subsystems by name. Everything else (core,
+# SoftDevice glue, libraries) is reported as "other" without a budget.
+# Exits with 1 when a subsystem exceeds its budget, so it can gate a build:
+#
+#   arduino-cli compile --fqbn rakwireless:nrf52:WisCoreRAK4631Board \
+#       --output-dir build . && extras/footprint/footprint.py build/SMX_v0_3_SPARK.ino.elf
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+SUBSYSTEMS = [
+    ("sensor", r"ImpedanceMeter|impedanceMeter|TemperatureSensor|tempSensor|PowerManager|powerManager|"
+               r"PowerMonitor|SignalChain|TraceRecorder|\btrace\b|sensorStack|sensorTask|AD5933|"
+               r"ChannelScheduler|selectChannel"),
+    ("radio", r"LoRaWANHandler|loraHandler|Airtime|DutyCycleBudget|PayloadCodec|Aggregator|aggregator|"
+              r"RunningStats|radioStack|radioTask|transmit|[Ll]atency|EmptyUplink"),
+    ("tasks", r"EventQueue|eventQueue|MeasurementQueue|measurementQueue|WakeScheduler|wakeScheduler|"
+              r"handle[A-Z]\w*State|runMeasurement|initializeSystem|periodicWakeup|armWakeTimer"),
+    ("storage", r"EEPROMManager|eepromManager|ExternalEEPROM|\beeprom\b"),
+]
+
+RAM_TYPES = set("bBdDsS")       # .bss, .data, small data
+FLASH_TYPES = set("tTrRdDwW")   # code, read-only data, initialised data
+
+
+def read_budgets(config_path):
+    budgets = {}
+    with open(config_path) as f:
+        text = f.read()
+    block = re.search(r"namespace MemoryBudget\s*\{(.*?)\}", text, re.S)
+    if block:
+        for name, value in re.findall(r"constexpr\s+\w+\s+(\w+)\s*=\s*(\d+)", block.group(1)):
+            budgets[name] = int(value)
+    return budgets
+
+
+def classify(symbol):
+    for name, pattern in SUBSYSTEMS:
+        if re.search(pattern, symbol):
+            return name
+    return "other"
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser()
+    parser.add_argument("elf")
+    parser.add_argument("-c", "--config", default=os.path.join(here, "..", "..", "config.h"))
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("-v", "--verbose", action="store_true", help="list the largest symbols")
+    args = parser.parse_args()
+
+    budgets = read_budgets(args.config)
+    output = subprocess.run([args.nm, "-S", "-C", "--size-sort", args.elf],
+                            check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+
+    totals = {name: {"ram": 0, "flash": 0} for name, _ in SUBSYSTEMS + [("other", "")]}
+    symbols = []
+    for line in output.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        size, kind, symbol = int(parts[1], 16), parts[2], parts[3]
+        group = classify(symbol)
+        if kind in RAM_TYPES:
+            totals[group]["ram"] += size
+        if kind in FLASH_TYPES:
+            totals[group]["flash"] += size
+        symbols.append((size, kind, group, symbol))
+
+    failed = False
+    print("%-8s %8s %8s %6s %9s %9s %6s" % ("subsys", "ram", "budget", "use", "flash", "budget", "use"))
+    for name in [n for n, _ in SUBSYSTEMS] + ["other"]:
+        row = [name]
+        for kind in ("ram", "flash"):
+            used = totals[name][kind]
+            budget = budgets.get("%s_%s" % (name.upper(), kind.upper()))
+            if budget:
+                row += [used, budget, "%5.1f%%" % (100.0 * used / budget)]
+                failed |= used > budget
+            else:
+                row += [used, "-", "-"]
+        print("%-8s %8s %8s %6s %9s %9s %6s" % tuple(row))
+
+    if args.verbose:
+        print("\nLargest application symbols:")
+        for size, kind, group, symbol in sorted(symbols, reverse=True)[:40]:
+            if group != "other":
+                print("%8d %s %-8s %s" % (size, kind, group, symbol))
+
+    if failed:
+        print("\nFAIL: subsystem over budget (MemoryBudget in config.h)")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
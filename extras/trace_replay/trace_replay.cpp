@@ -0,0 +1,269 @@
+// extras/trace_replay/trace_replay.cpp
+//
+// Host replay of SMX sensor traces (TraceFormat, see trace_format.h)
+// through the firmware signal chain. Recomputes HL, HH, Temp and Batt for
+// every recorded cycle, compares them with what the node reported and times
+// the chain.
+//
+// Build:  make -C extras trace_replay/trace_replay
+// Usage:  trace_replay [-r repeats] [-t tolerance] [-b max_ns_per_cycle] [-v] trace.log
+//        trace_replay reference.log     (reference trace in this directory)
+//
+// Exits with 1 when a recomputed moisture differs by more than the
+// tolerance or the time per cycle exceeds the budget, so it can gate
+// changes to the signal chain on recorded field data.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "signal_chain.h"
+#include "trace_format.h"
+
+struct Sweep {
+    std::vector<int16_t> real;
+    std::vector<int16_t> imag;
+};
+
+struct Channel {
+    bool present = false;
+    double gain = 0;
+    uint16_t Cmin = 0;
+    uint16_t Cmax = 0;
+    std::vector<Sweep> sweeps;
+};
+
+struct Cycle {
+    uint32_t timestamp = 0;
+    Channel channels[2];
+    bool hasTemp = false;
+    int16_t tempCount = 0;
+    std::vector<uint16_t> batt;
+    bool hasResult = false;
+    int8_t hl = 0, hh = 0, batteryLevel = 0;
+    int16_t temp = 0;
+};
+
+struct Outputs {
+    int8_t hl, hh, batteryLevel;
+    int temp;
+};
+
+static uint32_t centreFreq = SignalChain::MID_FREQ;
+static uint8_t traceVersion = TraceFormat::VERSION;
+
+static uint16_t get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t* p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Decodes one "TRC ..." line, returns false on bad hex, length or CRC
+static bool decodeLine(const char* line, std::vector<uint8_t>& record) {
+    const char* hex = strstr(line, TraceFormat::LINE_PREFIX);
+    if (!hex) return false;
+    hex += strlen(TraceFormat::LINE_PREFIX);
+
+    record.clear();
+    while (hexValue(hex[0]) >= 0 && hexValue(hex[1]) >= 0) {
+        record.push_back((uint8_t)(hexValue(hex[0]) << 4 | hexValue(hex[1])));
+        hex += 2;
+    }
+    if (record.size() < 3 || record[1] + 3u != record.size()) return false;
+    return TraceFormat::crc8(record.data(), record.size() - 1) == record.back();
+}
+
+static bool loadTrace(const char* path, std::vector<Cycle>& cycles, unsigned& badRecords) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    char line[512];
+    std::vector<uint8_t> rec;
+    int channel = 0;
+    badRecords = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        if (!strstr(line, TraceFormat::LINE_PREFIX)) continue;
+        if (!decodeLine(line, rec)) {
+            badRecords++;
+            continue;
+        }
+        const uint8_t* body = rec.data() + 2;
+        uint8_t length = rec[1];
+
+        switch (rec[0]) {
+            case TraceFormat::REC_HEADER:
+                if (length >= 12 && memcmp(body, "SMXT", 4) == 0 && body[5] > 0) {
+                    traceVersion = body[4];
+                    centreFreq = get32(body + 6) + get16(body + 10) * (body[5] - 1) / 2;
+                }
+                break;
+            case TraceFormat::REC_CYCLE:
+                cycles.push_back(Cycle());
+                cycles.back().timestamp = get32(body);
+                break;
+            case TraceFormat::REC_CAL:
+                if (cycles.empty() || length < 13) break;
+                channel = body[0];
+                if (channel > 1) break;     // Only HL and HH have recorded results
+                {
+                    Channel& ch = cycles.back().channels[channel];
+                    ch.present = true;
+                    memcpy(&ch.gain, body + 1, sizeof(double));
+                    ch.Cmin = get16(body + 9);
+                    ch.Cmax = get16(body + 11);
+                }
+                break;
+            case TraceFormat::REC_SWEEP:
+                if (cycles.empty() || length < 3 || length < 3 + body[2] * 4 || body[0] > 1) break;
+                {
+                    Sweep sweep;
+                    for (uint8_t i = 0; i < body[2]; i++) {
+                        sweep.real.push_back((int16_t)get16(body + 3 + i * 4));
+                        sweep.imag.push_back((int16_t)get16(body + 5 + i * 4));
+                    }
+                    cycles.back().channels[body[0]].sweeps.push_back(sweep);
+                }
+                break;
+            case TraceFormat::REC_TEMP:
+                if (cycles.empty() || length < 2) break;
+                cycles.back().hasTemp = true;
+                cycles.back().tempCount = (int16_t)get16(body);
+                break;
+            case TraceFormat::REC_BATT:
+                if (cycles.empty() || length < 1 + body[0] * 2) break;
+                for (uint8_t i = 0; i < body[0]; i++) {
+                    cycles.back().batt.push_back(get16(body + 1 + i * 2));
+                }
+                break;
+            case TraceFormat::REC_RESULT:
+                if (cycles.empty() || length < 5) break;
+                cycles.back().hasResult = true;
+                cycles.back().hl = (int8_t)body[0];
+                cycles.back().hh = (int8_t)body[1];
+                cycles.back().temp = (int16_t)get16(body + 2);
+                cycles.back().batteryLevel = (int8_t)body[4];
+                break;
+            default:
+                badRecords++;
+                break;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// Same chain as ImpedanceMeter::getMoisture(), at the traced sweep frequencies
+static int replayChannel(const Channel& ch, float temp) {
+    SignalChain::SweepSum sweeps;
+
+    for (size_t i = 0; i < ch.sweeps.size(); i++) {
+        const Sweep& s = ch.sweeps[i];
+        sweeps.add(SignalChain::sweepMagnitude(s.real.data(), s.imag.data(), s.real.size()));
+    }
+    return SignalChain::sweepMoisture(sweeps, ch.gain, ch.Cmin, ch.Cmax, temp, centreFreq);
+}
+
+// Mirrors handleMeasurementState(): battery, temperature, then HL and HH
+static Outputs replayCycle(const Cycle& c) {
+    Outputs out;
+    out.batteryLevel = c.batt.empty() ? c.batteryLevel
+                                      : (int8_t)SignalChain::batteryLevel(c.batt.data(), c.batt.size());
+    out.temp = !c.hasTemp ? c.temp
+             : (traceVersion >= 3) ? SignalChain::temperature(c.tempCount)
+             : (int)(SignalChain::celsius(c.tempCount) + 0.5f);    // Truncated toward zero below 0 C
+
+    // Version 1 firmware compensated with the rounded temperature
+    float compTemp = (c.hasTemp && traceVersion >= 2) ? SignalChain::celsius(c.tempCount) : out.temp;
+    out.hl = (int8_t)replayChannel(c.channels[0], compTemp);
+    out.hh = (int8_t)replayChannel(c.channels[1], compTemp);
+    return out;
+}
+
+int main(int argc, char** argv) {
+    unsigned repeats = 1000;
+    int tolerance = 0;
+    double budgetNs = 0;
+    bool verbose = false;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) repeats = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) tolerance = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) budgetNs = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-v")) verbose = true;
+        else path = argv[i];
+    }
+    if (!path || repeats == 0) {
+        fprintf(stderr, "usage: %s [-r repeats] [-t tolerance] [-b max_ns_per_cycle] [-v] trace.log\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Cycle> cycles;
+    unsigned badRecords = 0;
+    if (!loadTrace(path, cycles, badRecords)) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 2;
+    }
+    if (cycles.empty()) {
+        fprintf(stderr, "no cycles in %s\n", path);
+        return 2;
+    }
+
+    // Accuracy against the values the node reported
+    unsigned compared = 0, mismatches = 0;
+    int maxDiff = 0;
+    long sumDiff = 0;
+    for (size_t i = 0; i < cycles.size(); i++) {
+        const Cycle& c = cycles[i];
+        if (!c.hasResult) continue;
+        Outputs out = replayCycle(c);
+        int diffs[2] = { out.hl - c.hl, out.hh - c.hh };
+        compared++;
+        for (int d : diffs) {
+            int ad = abs(d);
+            sumDiff += ad;
+            if (ad > maxDiff) maxDiff = ad;
+            if (ad > tolerance) mismatches++;
+        }
+        if (verbose || abs(diffs[0]) > tolerance || abs(diffs[1]) > tolerance) {
+            printf("cycle %zu @%u ms: HL %d -> %d, HH %d -> %d, Temp %d -> %d, Batt %d -> %d\n",
+                   i, c.timestamp, c.hl, out.hl, c.hh, out.hh, c.temp, out.temp,
+                   c.batteryLevel, out.batteryLevel);
+        }
+    }
+
+    // CPU cost of the chain, excluding parsing
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < cycles.size(); i++) {
+            Outputs out = replayCycle(cycles[i]);
+            sink = sink + out.hl + out.hh;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double totalNs = std::chrono::duration<double, std::nano>(elapsed).count();
+    double nsPerCycle = totalNs / ((double)repeats * cycles.size());
+
+    printf("trace:        %s\n", path);
+    printf("cycles:       %zu (%u with results, %u bad records)\n", cycles.size(), compared, badRecords);
+    printf("moisture:     %u mismatches > %d, max |diff| %d, mean |diff| %.3f\n",
+           mismatches, tolerance, maxDiff, compared ? (double)sumDiff / (2 * compared) : 0.0);
+    printf("cost:         %.1f ns/cycle\n", nsPerCycle);
+    printf("throughput:   %.0f cycles/s\n", 1e9 / nsPerCycle);
+
+    bool failed = mismatches > 0;
+    if (budgetNs > 0 && nsPerCycle > budgetNs) {
+        printf("FAIL: %.1f ns/cycle exceeds budget of %.1f ns\n", nsPerCycle, budgetNs);
+        failed = true;
+    }
+    return failed ? 1 : 0;
+}
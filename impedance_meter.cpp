@@ -1,69 +1,102 @@
 // sensors/impedance_meter.cpp
 #include "impedance_meter.h"
+#include "trace_recorder.h"
 
 bool ImpedanceMeter::initialize() {
+    trace.begin(SignalChain::NUM_POINTS, SignalChain::START_FREQ, SignalChain::FREQ_INCR);
     return (AD5933::reset() &&
             AD5933::setInternalClock(true) &&
-            AD5933::setStartFrequency(START_FREQ) &&
-            AD5933::setIncrementFrequency(FREQ_INCR) &&
-            AD5933::setNumberIncrements(NUM_INCR) &&
+            AD5933::setSettlingCycles(SETTLING_CYCLES) &&
+            AD5933::setStartFrequency(SignalChain::START_FREQ) &&
+            AD5933::setIncrementFrequency(SignalChain::FREQ_INCR) &&
+            AD5933::setNumberIncrements(SignalChain::NUM_INCR) &&
             AD5933::setPGAGain(PGA_GAIN_X1));
 }
 
-double ImpedanceMeter::measureImpedance(double gain) {
-    float sumMagnitude = 0;
-    uint8_t validSamples = 0;
+// Sleeps the calling task until the current point should be converted, then
+// checks the status register. Only retries a bounded number of ticks.
+bool ImpedanceMeter::waitForPoint(uint32_t freq) {
+    // vTaskDelay(n) can wake up to one tick early, the extra tick makes
+    // the point time a minimum
+    TickType_t ticks = (pointTimeUs(freq) * (uint64_t)configTICK_RATE_HZ + 999999UL) / 1000000UL;
+    vTaskDelay(ticks + 1);
+
+    for (uint8_t poll = 0; poll < MAX_POLLS_PER_POINT; poll++) {
+        sweepStats.polls++;
+        if ((AD5933::readStatusRegister() & STATUS_DATA_VALID) == STATUS_DATA_VALID) {
+            return true;
+        }
+        vTaskDelay(1);
+    }
+
+    sweepStats.timeouts++;
+    return false;
+}
+
+bool ImpedanceMeter::runSweep(uint8_t sample, double& magnitude) {
     int real, imag;
+    int16_t reals[SignalChain::NUM_POINTS];
+    int16_t imags[SignalChain::NUM_POINTS];
+    magnitude = 0;
 
     if (!(AD5933::setPowerMode(POWER_STANDBY) &&
           AD5933::setControlMode(CTRL_INIT_START_FREQ) &&
           AD5933::setControlMode(CTRL_START_FREQ_SWEEP))) {
-        return -1;
+        return false;
     }
 
-    for (uint8_t sample = 0; sample < NUM_SAMPLES; sample++) {
-        double magnitude = 0;
-        int i = 0;
-
-        while ((AD5933::readStatusRegister() & STATUS_SWEEP_DONE) != STATUS_SWEEP_DONE) {
-            if (!AD5933::getComplexData(&real, &imag)) {
-                continue;
-            }
+    for (uint8_t i = 0; i < SignalChain::NUM_POINTS; i++) {
+        if (!waitForPoint(SignalChain::START_FREQ + (uint32_t)SignalChain::FREQ_INCR * i)) {
+            return false;
+        }
+        if (!AD5933::getComplexData(&real, &imag)) {
+            sweepStats.readErrors++;
+            return false;
+        }
+        sweepStats.points++;
+        reals[i] = real;
+        imags[i] = imag;
 
-            if (i == 1) {
-                magnitude = sqrt(pow(real, 2) + pow(imag, 2));
-            }
-            if (i >= 2) {
-                double magnread = sqrt(pow(real, 2) + pow(imag, 2));
-                magnitude = (magnitude + magnread) / 2;
-            }
-            i++;
+        if (i < SignalChain::NUM_INCR) {
             AD5933::setControlMode(CTRL_INCREMENT_FREQ);
         }
+    }
 
-        if (magnitude > 0) {
-            sumMagnitude += magnitude;
-            validSamples++;
+    trace.recordSweep(sample, reals, imags, SignalChain::NUM_POINTS);
+    magnitude = SignalChain::sweepMagnitude(reals, imags, SignalChain::NUM_POINTS);
+    return true;
+}
+
+SignalChain::SweepSum ImpedanceMeter::measureSweeps() {
+    SignalChain::SweepSum sweeps;
+    uint8_t errors = 0;
+    sweepStats = {};
+
+    for (uint8_t sample = 0; sample < SignalChain::NUM_SAMPLES && errors < MAX_SWEEP_ERRORS; sample++) {
+        double magnitude = 0;
+
+        if (!runSweep(sample, magnitude)) {
+            errors++;
+            continue;
         }
+
+        sweeps.add(magnitude);
         delay(10);
     }
 
     AD5933::setPowerMode(POWER_DOWN);
-    //return (validSamples > 0) ? (sumMagnitude / validSamples) : -1;
-    return (validSamples > 0) ? 1/((sumMagnitude / validSamples)*gain)-204 : -1;
+    Serial.printf("Sweep: %u points, %u polls, %u timeouts, %u read errors\n",
+                  sweepStats.points, sweepStats.polls, sweepStats.timeouts, sweepStats.readErrors);
+    return sweeps;
 }
 
 int ImpedanceMeter::getMoisture(double gain, int Cmin, int Cmax, float temp) {
-    double impedance = measureImpedance(gain);
+    double impedance = -1, Cin = 0;
+    int moisture = SignalChain::sweepMoisture(measureSweeps(), gain, Cmin, Cmax, temp,
+                                              SignalChain::MID_FREQ, &impedance, &Cin);
     Serial.print("imped: "); Serial.println(impedance);
-    if (impedance < 0) return -1;
-    //float Cin=1E+12/2/M_PI/(START_FREQ+FREQ_INCR*NUM_INCR/2)/impedance;Serial.print(" Cin_flt = ");Serial.println(Cin);
-    double Cin = 1E+12 / (2 * M_PI * (START_FREQ + FREQ_INCR * NUM_INCR / 2) * impedance); Serial.print("Cin_dbl: "); Serial.println(Cin);
-    Cin = tempCompensation(Cin, temp);
-
-    return constrain(abs((Cin - Cmin) * 100 / (Cmax - Cmin)), 0, 100);
-}
-
-float ImpedanceMeter::tempCompensation(float capacitance, float temp) {
-    return capacitance * (1 + TEMP_COEFF * (temp - REF_TEMP));
+    if (moisture >= 0) {
+        Serial.print("Cin: "); Serial.println(Cin);
+    }
+    return moisture;
 }
@@ -4,20 +4,37 @@
 
 #include "main.h"
 #include <AD5933.h>
+#include "signal_chain.h"
+
+// Per-measurement sweep counters, reset at the start of measureSweeps()
+struct SweepStats {
+    uint16_t points;      // Frequency points read
+    uint16_t polls;       // Status register reads
+    uint16_t timeouts;    // Points that never became valid
+    uint16_t readErrors;  // Failed real/imag register reads
+};
 
 class ImpedanceMeter {
 public:
     bool initialize();
     int getMoisture(double gain, int Cmin, int Cmax, float temp);
+    const SweepStats& getSweepStats() const { return sweepStats; }
 
 private:
-    double measureImpedance(double gain);
-    float tempCompensation(float capacitance, float temp);
-    
-    static constexpr uint32_t START_FREQ = 99930;
-    static constexpr uint16_t FREQ_INCR = 10;
-    static constexpr uint8_t NUM_INCR = 12;
-    static constexpr uint8_t NUM_SAMPLES = 5;
-    static constexpr float TEMP_COEFF = 0.02;
-    static constexpr float REF_TEMP = 25.0;
-};
\ No newline at end of file
+    SignalChain::SweepSum measureSweeps();
+    bool runSweep(uint8_t sample, double& magnitude);
+    bool waitForPoint(uint32_t freq);
+
+    // Settling time of the excitation plus the 1024-sample DFT at MCLK/16
+    static constexpr uint32_t pointTimeUs(uint32_t freq) {
+        return (uint32_t)((uint64_t)SETTLING_CYCLES * 1000000UL / freq) + DFT_TIME_US;
+    }
+
+    SweepStats sweepStats = {};
+
+    static constexpr uint32_t MCLK_HZ = 16776000;      // Internal oscillator
+    static constexpr uint16_t SETTLING_CYCLES = 15;
+    static constexpr uint32_t DFT_TIME_US = (1024UL * 16 * 1000000UL + MCLK_HZ - 1) / MCLK_HZ;
+    static constexpr uint8_t MAX_POLLS_PER_POINT = 4;  // Expected time + 3 tick retries
+    static constexpr uint8_t MAX_SWEEP_ERRORS = 3;     // Give up on the measurement after this
+};
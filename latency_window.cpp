@@ -0,0 +1,75 @@
+// communication/latency_window.cpp
+#include "latency_window.h"
+#include "config.h"
+
+LatencyWindow::LatencyWindow()
+    : current(OFF), closing(false), openedMs(0), endMs(0), currentDrawUa(0), periodStartMs(0), usedUas(0) {
+}
+
+uint32_t LatencyWindow::drawUa(Mode mode, uint32_t uplinkAirtimeMs) {
+    switch (mode) {
+        case CLASS_C:
+            return LatencyConfig::RX_CURRENT_UA;
+        case BURST:
+            return ((uint64_t)uplinkAirtimeMs * LatencyConfig::TX_CURRENT_UA +
+                    (uint64_t)LatencyConfig::RX_WINDOWS_MS * LatencyConfig::RX_CURRENT_UA) /
+                   LatencyConfig::BURST_INTERVAL_MS;
+        default:
+            return 0;
+    }
+}
+
+void LatencyWindow::rollPeriod(uint32_t nowMs) {
+    if (nowMs - periodStartMs >= PERIOD_MS) {
+        periodStartMs = nowMs;
+        usedUas = 0;
+    }
+}
+
+uint32_t LatencyWindow::remainingChargeMas(uint32_t nowMs) {
+    rollPeriod(nowMs);
+    uint32_t budgetUas = LatencyConfig::DAILY_BUDGET_MAS * 1000;
+    return (usedUas < budgetUas) ? (budgetUas - usedUas) / 1000 : 0;
+}
+
+uint32_t LatencyWindow::remainingMs(uint32_t nowMs) const {
+    if (!isOpen() || expired(nowMs)) return 0;
+    return endMs - nowMs;
+}
+
+uint32_t LatencyWindow::open(Mode mode, uint8_t minutes, uint32_t nowMs, uint32_t uplinkAirtimeMs) {
+    if (isOpen()) {
+        close(nowMs);
+    }
+    uint32_t draw = drawUa(mode, uplinkAirtimeMs);
+    if (draw == 0 || minutes == 0) {
+        return 0;
+    }
+
+    if (minutes > LatencyConfig::MAX_WINDOW_MIN) {
+        minutes = LatencyConfig::MAX_WINDOW_MIN;
+    }
+    uint64_t lengthMs = SystemConstants::MIN_TO_MS(minutes);
+    uint64_t affordableMs = (uint64_t)remainingChargeMas(nowMs) * 1000000ULL / draw;
+    if (affordableMs < lengthMs) {
+        lengthMs = affordableMs;
+    }
+    if (lengthMs == 0) {
+        return 0;
+    }
+
+    current = mode;
+    openedMs = nowMs;
+    endMs = nowMs + (uint32_t)lengthMs;
+    currentDrawUa = draw;
+    return (uint32_t)lengthMs;
+}
+
+void LatencyWindow::close(uint32_t nowMs) {
+    if (!isOpen()) return;
+
+    rollPeriod(nowMs);
+    usedUas += (uint64_t)currentDrawUa * (nowMs - openedMs) / 1000;
+    current = OFF;
+    closing = false;
+}
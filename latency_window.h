@@ -0,0 +1,54 @@
+// communication/latency_window.h
+#ifndef LATENCY_WINDOW_H
+#define LATENCY_WINDOW_H
+
+#include <stdint.h>
+
+// Bounded low-latency downlink window. While open, the node either stays
+// in Class C or sends empty uplinks so RX1/RX2 open often. Each window is
+// capped in length and every window in a rolling 24 h period shares one
+// charge budget. The radio itself is driven by the caller.
+class LatencyWindow {
+public:
+    enum Mode : uint8_t {
+        OFF,
+        CLASS_C,
+        BURST
+    };
+
+    LatencyWindow();
+
+    // Opens a window of up to `minutes`, shortened to what the charge
+    // budget still covers. Returns the granted length, 0 if refused.
+    uint32_t open(Mode mode, uint8_t minutes, uint32_t nowMs, uint32_t uplinkAirtimeMs);
+    void close(uint32_t nowMs);     // Charges the time actually spent
+
+    // A Class C window stays charged after it ends until the MAC confirms
+    // Class A and the caller closes it
+    void startClosing() { closing = isOpen(); }
+    bool isClosing() const { return closing; }
+
+    bool isOpen() const { return current != OFF; }
+    Mode mode() const { return current; }
+    bool expired(uint32_t nowMs) const { return isOpen() && (int32_t)(nowMs - endMs) >= 0; }
+    uint32_t remainingMs(uint32_t nowMs) const;
+    uint32_t remainingChargeMas(uint32_t nowMs);
+
+    // Average draw of a mode in uA, on top of the sleep current
+    static uint32_t drawUa(Mode mode, uint32_t uplinkAirtimeMs);
+
+    static constexpr uint32_t PERIOD_MS = 86400000UL;
+
+private:
+    void rollPeriod(uint32_t nowMs);
+
+    Mode current;
+    bool closing;
+    uint32_t openedMs;
+    uint32_t endMs;
+    uint32_t currentDrawUa;
+    uint32_t periodStartMs;
+    uint32_t usedUas;       // Charge spent in this period, uA * s
+};
+
+#endif // LATENCY_WINDOW_H
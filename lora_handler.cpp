@@ -1,5 +1,7 @@
 // src/communication/lora_handler.cpp
 #include "lora_handler.h"
+#include "airtime.h"
+#include "event_queue.h"
 
 // Initialize static members
 /*//60002
@@ -20,7 +22,10 @@ bool LoRaWANHandler::doOTAA = true;  // Add this definition
 
 LoRaWANHandler::LoRaWANHandler() : 
     measurementCallback(nullptr),
-    intervalCallback(nullptr) {
+    intervalCallback(nullptr),
+    reportCallback(nullptr),
+    timeSyncCallback(nullptr),
+    latencyCallback(nullptr) {
     m_lora_app_data.buffer = m_lora_app_data_buffer;
     m_lora_app_data.buffsize = 0;
     m_lora_app_data.port = 0;
@@ -76,14 +81,17 @@ void LoRaWANHandler::handleRxData(lmh_app_data_t* app_data) {
 void LoRaWANHandler::handleJoinSuccess() {
     Serial.println("OTAA join successful");
     digitalWrite(LED_CONN, LOW);
+    eventQueue.post(EventType::JOIN_RESULT, EventSource::LORA_MAC, 1);
 }
 
 void LoRaWANHandler::handleClassConfirmation(DeviceClass_t Class) {
     Serial.printf("Switch to class %c done\n", "ABC"[Class]);
+    eventQueue.post(EventType::CLASS_CHANGED, EventSource::LORA_MAC, Class, 1);
 }
 
 void LoRaWANHandler::handleJoinFailure() {
     Serial.println("OTAA join failed!");
+    eventQueue.post(EventType::JOIN_RESULT, EventSource::LORA_MAC, 0);
 }
 
 void LoRaWANHandler::setupCallbacks() {
@@ -100,9 +108,9 @@ void LoRaWANHandler::setupCallbacks() {
     // Initialize LoRaWAN with callbacks
     lmh_param_t lora_param_init = {
         LORAWAN_ADR_OFF,
-        DR_3,
+        LORAWAN_DATARATE,
         LORAWAN_PUBLIC_NETWORK,
-        JOINREQ_NBTRIALS,
+        LoRaConfig::JOIN_TRIALS,
         LORAWAN_DEFAULT_TX_POWER,
         LORAWAN_DUTYCYCLE_OFF
     };
@@ -118,7 +126,7 @@ bool LoRaWANHandler::sendData(const uint8_t* data, uint8_t length) {
         return false;
     }
 
-    if (length > LORAWAN_APP_DATA_BUFF_SIZE) {
+    if (length > LoRaConfig::DATA_BUFF_SIZE) {
         Serial.println("Data too long");
         return false;
     }
@@ -133,7 +141,7 @@ bool LoRaWANHandler::sendData(const uint8_t* data, uint8_t length) {
     return (lmh_send(&m_lora_app_data, LMH_UNCONFIRMED_MSG) == 0);
 }*/
 
-bool LoRaWANHandler::sendData(const uint8_t* data, uint8_t length) {
+bool LoRaWANHandler::sendData(const uint8_t* data, uint8_t length, uint8_t port) {
     Serial.println("\nLoRaWAN Send Data:");
     
     if (!lmh_join_status_get()) {
@@ -149,14 +157,30 @@ bool LoRaWANHandler::sendData(const uint8_t* data, uint8_t length) {
     }
     Serial.println("]");
 
-    m_lora_app_data.port = LORAWAN_APP_PORT;
-    memcpy(m_lora_app_data_buffer, data, length);
+    if (length > LoRaConfig::DATA_BUFF_SIZE) {
+        Serial.println("ERROR: Payload too long!");
+        return false;
+    }
+
+    uint32_t airtime = airtimeMs(length);
+    if (!canSend(length)) {
+        Serial.printf("ERROR: Duty cycle budget exceeded (%lu ms needed, %lu ms left)\n",
+                      airtime, remainingAirtimeMs());
+        return false;
+    }
+
+    m_lora_app_data.port = port;
+    if (length > 0) {
+        memcpy(m_lora_app_data_buffer, data, length);
+    }
     m_lora_app_data.buffsize = length;
 
     lmh_error_status error = lmh_send(&m_lora_app_data, LMH_UNCONFIRMED_MSG);
     
     if (error == 0) {
-        Serial.println("LoRa send request successful");
+        dutyCycle.record(UPLINK_BAND, millis(), airtime);
+        Serial.printf("LoRa send request successful (%lu ms on air, %d%% of hourly budget used)\n",
+                      airtime, dutyCycleUsage());
         return true;
     } else {
         Serial.printf("LoRa send failed with error: %d\n", error);
@@ -164,6 +188,41 @@ bool LoRaWANHandler::sendData(const uint8_t* data, uint8_t length) {
     }
 }
 
+// Completion is reported through handleClassConfirmation. Only called
+// from the radio task, LoRaMAC is not re-entrant.
+bool LoRaWANHandler::requestClass(DeviceClass_t deviceClass) {
+    DeviceClass_t currentClass;
+    lmh_class_get(&currentClass);
+    if (currentClass == deviceClass) {
+        // lmh_class_request succeeds without a confirmation in this case
+        handleClassConfirmation(deviceClass);
+        return true;
+    }
+
+    lmh_error_status error = lmh_class_request(deviceClass);
+    if (error != LMH_SUCCESS) {
+        Serial.printf("Class %c request failed with error: %d\n", "ABC"[deviceClass], error);
+        return false;
+    }
+    return true;
+}
+
+uint32_t LoRaWANHandler::airtimeMs(uint8_t length) {
+    return (Airtime::timeOnAirUs(LORAWAN_DATARATE, length) + 999) / 1000;
+}
+
+bool LoRaWANHandler::canSend(uint8_t length) const {
+    return dutyCycle.canSend(UPLINK_BAND, millis(), airtimeMs(length));
+}
+
+uint32_t LoRaWANHandler::remainingAirtimeMs() const {
+    return dutyCycle.remainingMs(UPLINK_BAND, millis());
+}
+
+uint8_t LoRaWANHandler::dutyCycleUsage() const {
+    return dutyCycle.usagePercent(UPLINK_BAND, millis());
+}
+
 // Also add debug messages to join callback
 static void lorawan_has_joined_handler(void) {
     Serial.println("\n*** LoRaWAN Network Joined! ***");
@@ -211,6 +270,28 @@ void LoRaWANHandler::handleDownlink(const uint8_t* data, uint8_t size) {
             NVIC_SystemReset();
             break;
 
+        case 0x04: // Update report period (measurements per summary)
+            Serial.println("case 04");
+            if (size >= 2 && reportCallback != nullptr) {
+                reportCallback(data[1]);
+            }
+            break;
+
+        case 0x05: // Time sync, Unix seconds big-endian
+            Serial.println("case 05");
+            if (size >= 5 && timeSyncCallback != nullptr) {
+                timeSyncCallback(((uint32_t)data[1] << 24) | ((uint32_t)data[2] << 16) |
+                                 ((uint32_t)data[3] << 8) | data[4]);
+            }
+            break;
+
+        case 0x06: // Latency window: minutes (0 closes), mode 0 Class C / 1 uplink burst
+            Serial.println("case 06");
+            if (size >= 2 && latencyCallback != nullptr) {
+                latencyCallback(data[1], size >= 3 ? data[2] : 0);
+            }
+            break;
+
         default:
             Serial.printf("Unknown command: 0x%02X\n", data[0]);
             break;
@@ -4,11 +4,12 @@
 
 #include "main.h"
 #include "eeprom_manager.h"  // Include the full definition
+#include "duty_cycle.h"
+#include "lora_config.h"
 
 
 // LoRaWAN constants
-#define JOINREQ_NBTRIALS 8
-#define LORAWAN_APP_DATA_BUFF_SIZE 64
+#define LORAWAN_DATARATE DR_3
 
 class LoRaWANHandler {
 
@@ -17,27 +18,52 @@ public:
     // Define callback types for downlink handling
     typedef void (*MeasurementRequestCallback)();
     typedef void (*IntervalUpdateCallback)(uint8_t newInterval);        
+    typedef void (*ReportUpdateCallback)(uint8_t reportEvery);
+    typedef void (*TimeSyncCallback)(uint32_t epochSeconds);
+    typedef void (*LatencyModeCallback)(uint8_t minutes, uint8_t mode);
 
     LoRaWANHandler();
     bool initialize();
-    bool sendData(const uint8_t* data, uint8_t length);
+    bool sendData(const uint8_t* data, uint8_t length, uint8_t port = LORAWAN_APP_PORT);
+    bool requestClass(DeviceClass_t deviceClass);
+
+    // Time-on-air accounting for uplinks
+    static uint32_t airtimeMs(uint8_t length);
+    bool canSend(uint8_t length) const;
+    uint32_t remainingAirtimeMs() const;
+    uint8_t dutyCycleUsage() const;
     void handleDownlink(const uint8_t* data, uint8_t size);
 
     // Set callbacks
     void setCallbacks(MeasurementRequestCallback measurementCb,
-                     IntervalUpdateCallback intervalCb) {
+                     IntervalUpdateCallback intervalCb,
+                     ReportUpdateCallback reportCb = nullptr,
+                     TimeSyncCallback timeCb = nullptr,
+                     LatencyModeCallback latencyCb = nullptr) {
         measurementCallback = measurementCb;
         intervalCallback = intervalCb;
+        reportCallback = reportCb;
+        timeSyncCallback = timeCb;
+        latencyCallback = latencyCb;
     }
 
+    static const uint8_t* getDeviceEUI() { return deviceEUI; }
+
 private:
     // Declare these first
-    uint8_t m_lora_app_data_buffer[LORAWAN_APP_DATA_BUFF_SIZE];
+    uint8_t m_lora_app_data_buffer[LoRaConfig::DATA_BUFF_SIZE];
     lmh_app_data_t m_lora_app_data;
+    DutyCycleBudget dutyCycle;
+
+    // Uplinks use the default EU868 channels, which all sit in sub-band g
+    static constexpr DutyCycleBudget::SubBand UPLINK_BAND = DutyCycleBudget::BAND_G;
 
     // Callback pointers
     MeasurementRequestCallback measurementCallback;
     IntervalUpdateCallback intervalCallback;
+    ReportUpdateCallback reportCallback;
+    TimeSyncCallback timeSyncCallback;
+    LatencyModeCallback latencyCallback;
 
     
     // Static members for LoRaWAN configuration
@@ -8,7 +8,6 @@
 #include <Wire.h>
 #include <LoRaWan-RAK4630.h>
 #include <PCA9536D.h>
-#include <SparkFunTMP102.h>
 //#include "Adafruit_EEPROM_I2C.h"
 #include <SparkFun_External_EEPROM.h>
 #include "config.h"
@@ -20,10 +19,11 @@ class ImpedanceMeter;
 class PowerManager;
 class LoRaWANHandler;
 class EEPROMManager;
+class TraceRecorder;
+class EventQueue;
 
 // Global variables declarations
 extern PCA9536 io;
-extern TMP102 STemp;
 //extern ExternalEEPROM LoraMem;
 extern uint8_t retryCount;
 
@@ -32,16 +32,16 @@ extern ImpedanceMeter* impedanceMeter;
 extern PowerManager* powerManager;
 extern LoRaWANHandler* loraHandler;
 //extern EEPROMManager* eepromManager;
+extern TraceRecorder trace;
+extern EventQueue eventQueue;
 
 extern SensorConfig config;
 extern SystemState currentState;
-extern int8_t HL;
-extern int8_t HH;
+extern int8_t Moisture[ChannelConfig::MAX_CHANNELS];
 extern int Temp;
 extern int8_t Batt;
 extern uint16_t SNr;
 extern uint32_t Time;
-extern SemaphoreHandle_t taskEvent;
 extern SoftwareTimer taskWakeupTimer;
 
 // Function declarations
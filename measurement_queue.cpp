@@ -0,0 +1,68 @@
+// tasks/measurement_queue.cpp
+#include "measurement_queue.h"
+
+bool MeasurementQueue::begin() {
+#if SMX_STATIC_ALLOC
+    handle = xQueueCreateStatic(TaskConfig::QUEUE_DEPTH, sizeof(MeasurementRecord), storage, &queueBuffer);
+#else
+    handle = xQueueCreate(TaskConfig::QUEUE_DEPTH, sizeof(MeasurementRecord));
+#endif
+    stats = {};
+    stats.latencyMinMs = UINT32_MAX;
+    return handle != nullptr;
+}
+
+bool MeasurementQueue::push(MeasurementRecord record) {
+    if (!handle) return false;
+
+    if (uxQueueSpacesAvailable(handle) == 0) {
+        MeasurementRecord oldest;
+        if (xQueueReceive(handle, &oldest, 0) == pdTRUE) {
+            stats.dropped++;
+        }
+    }
+
+    record.queuedAt = millis();
+    if (xQueueSend(handle, &record, 0) != pdTRUE) {
+        stats.dropped++;
+        return false;
+    }
+
+    stats.queued++;
+    stats.depth = depth();
+    if (stats.depth > stats.highWater) {
+        stats.highWater = stats.depth;
+    }
+    return true;
+}
+
+bool MeasurementQueue::peek(MeasurementRecord& record, TickType_t wait) {
+    return handle && xQueuePeek(handle, &record, wait) == pdTRUE;
+}
+
+bool MeasurementQueue::pop(MeasurementRecord& record) {
+    if (!handle || xQueueReceive(handle, &record, 0) != pdTRUE) {
+        return false;
+    }
+
+    uint32_t latency = millis() - record.queuedAt;
+    stats.delivered++;
+    stats.depth = depth();
+    stats.latencySumMs += latency;
+    if (latency < stats.latencyMinMs) stats.latencyMinMs = latency;
+    if (latency > stats.latencyMaxMs) stats.latencyMaxMs = latency;
+    return true;
+}
+
+uint16_t MeasurementQueue::depth() const {
+    return handle ? uxQueueMessagesWaiting(handle) : 0;
+}
+
+void MeasurementQueue::printStats() const {
+    Serial.printf("Queue: depth %u/%u (max %u), queued %lu, dropped %lu\n",
+                  stats.depth, TaskConfig::QUEUE_DEPTH, stats.highWater, stats.queued, stats.dropped);
+    if (stats.delivered > 0) {
+        Serial.printf("Queue latency: min %lu ms, avg %lu ms, max %lu ms\n",
+                      stats.latencyMinMs, stats.latencySumMs / stats.delivered, stats.latencyMaxMs);
+    }
+}
@@ -0,0 +1,58 @@
+// tasks/measurement_queue.h
+#ifndef MEASUREMENT_QUEUE_H
+#define MEASUREMENT_QUEUE_H
+
+#include "main.h"
+
+// Radio work that is not a measurement, queued as a record with mask 0 so
+// that only the radio task calls into the (non re-entrant) LoRaMAC
+enum class RadioCommand : uint8_t {
+    EMPTY_UPLINK,       // Opens RX1/RX2 for a queued downlink
+    REQUEST_CLASS_A,
+    REQUEST_CLASS_C
+};
+
+// One measurement cycle, passed from the sensor task to the radio task
+struct MeasurementRecord {
+    uint32_t timestamp;     // millis() when the cycle started
+    uint32_t queuedAt;      // millis() when the record was queued
+    int8_t moisture[ChannelConfig::MAX_CHANNELS];
+    uint8_t mask;           // Channels measured in this cycle
+    int16_t Temp;
+    int8_t Batt;
+    RadioCommand command;   // Only used with mask 0
+};
+
+struct QueueStats {
+    uint16_t depth;
+    uint16_t highWater;
+    uint32_t queued;
+    uint32_t dropped;       // Oldest records discarded because the queue was full
+    uint32_t delivered;
+    uint32_t latencyMinMs;  // Time from queueing to the radio task taking the record
+    uint32_t latencyMaxMs;
+    uint32_t latencySumMs;
+};
+
+// Fixed-size FreeRTOS queue of measurement records. When the radio is
+// busy or not joined the records wait here; a full queue drops the oldest.
+class MeasurementQueue {
+public:
+    bool begin();
+    bool push(MeasurementRecord record);
+    bool peek(MeasurementRecord& record, TickType_t wait);
+    bool pop(MeasurementRecord& record);
+    uint16_t depth() const;
+    const QueueStats& getStats() const { return stats; }
+    void printStats() const;
+
+private:
+    QueueHandle_t handle = nullptr;
+    QueueStats stats = {};
+#if SMX_STATIC_ALLOC
+    uint8_t storage[TaskConfig::QUEUE_DEPTH * sizeof(MeasurementRecord)];
+    StaticQueue_t queueBuffer;
+#endif
+};
+
+#endif // MEASUREMENT_QUEUE_H
@@ -0,0 +1,52 @@
+// communication/payload_codec.cpp
+#include "payload_codec.h"
+
+uint8_t PayloadCodec::encodeSample(uint8_t* buf, uint8_t size, int8_t hl, int8_t hh, int temp,
+                                   int8_t batt, uint16_t snr, uint8_t dsMin, uint8_t dutyUsed) {
+    if (size < SAMPLE_SIZE) {
+        return 0;
+    }
+
+    buf[0] = hl & 0xFF;
+    buf[1] = (hl >> 8) & 0xFF;
+    buf[2] = hh & 0xFF;
+    buf[3] = (hh >> 8) & 0xFF;
+    buf[4] = temp;
+    buf[5] = batt;
+    buf[6] = snr & 0xFF;
+    buf[7] = (snr >> 8) & 0xFF;
+    buf[8] = dsMin;
+    buf[9] = dutyUsed;
+    return SAMPLE_SIZE;
+}
+
+uint8_t PayloadCodec::channelsSize(uint8_t mask) {
+    uint8_t length = CHANNELS_OVERHEAD;
+    for (mask &= (1 << ChannelConfig::MAX_CHANNELS) - 1; mask; mask &= mask - 1) {
+        length++;
+    }
+    return length;
+}
+
+uint8_t PayloadCodec::encodeChannels(uint8_t* buf, uint8_t size, const int8_t* moisture, uint8_t mask,
+                                     int temp, int8_t batt, uint16_t snr, uint8_t dsMin, uint8_t dutyUsed) {
+    uint8_t length = channelsSize(mask);
+    if (size < length) {
+        return 0;
+    }
+
+    uint8_t* out = buf;
+    *out++ = mask;
+    for (uint8_t ch = 0; ch < ChannelConfig::MAX_CHANNELS; ch++) {
+        if (mask & (1 << ch)) {
+            *out++ = moisture[ch];
+        }
+    }
+    *out++ = temp;
+    *out++ = batt;
+    *out++ = snr & 0xFF;
+    *out++ = (snr >> 8) & 0xFF;
+    *out++ = dsMin;
+    *out++ = dutyUsed;
+    return length;
+}
@@ -0,0 +1,30 @@
+// communication/payload_codec.h
+#ifndef PAYLOAD_CODEC_H
+#define PAYLOAD_CODEC_H
+
+#include "config.h"
+
+// Uplink frame encoding for single measurements. HL + HH go out in the
+// original frame on the application port, any other channel set in the
+// variable frame on ChannelConfig::SAMPLE_PORT.
+// Summary frames are encoded by Aggregator::encodeSummary().
+namespace PayloadCodec {
+    // [0..1] HL  [2..3] HH  [4] Temp  [5] Batt  [6..7] SNr  [8] DS_min
+    // [9] duty cycle budget used in the last hour, percent
+    constexpr uint8_t SAMPLE_SIZE = 10;
+
+    // [0] channel mask  then one moisture byte per set channel, lowest first,
+    // then Temp, Batt, SNr (2), DS_min and duty cycle used
+    constexpr uint8_t CHANNELS_OVERHEAD = 7;
+    constexpr uint8_t MAX_CHANNELS_SIZE = CHANNELS_OVERHEAD + ChannelConfig::MAX_CHANNELS;
+
+    // Returns the frame length, or 0 if buf is too small
+    uint8_t encodeSample(uint8_t* buf, uint8_t size, int8_t hl, int8_t hh, int temp,
+                         int8_t batt, uint16_t snr, uint8_t dsMin, uint8_t dutyUsed);
+
+    uint8_t channelsSize(uint8_t mask);
+    uint8_t encodeChannels(uint8_t* buf, uint8_t size, const int8_t* moisture, uint8_t mask, int temp,
+                           int8_t batt, uint16_t snr, uint8_t dsMin, uint8_t dutyUsed);
+}
+
+#endif // PAYLOAD_CODEC_H
@@ -1,5 +1,7 @@
 // power/power_manager.cpp
 #include "power_manager.h"
+#include "signal_chain.h"
+#include "trace_recorder.h"
 #include <Wire.h>
 
 void PowerManager::enterLowPowerMode() {
@@ -33,7 +35,7 @@ void PowerManager::wakeUp() {
 }
 
 float PowerManager::getBatteryLevel() {
-    float voltage = 0;
+    uint16_t raw[BATTERY_SAMPLES];
     
     // Configure ADC
     analogReference(AR_INTERNAL_3_0);
@@ -45,18 +47,16 @@ float PowerManager::getBatteryLevel() {
     
     // Take multiple samples
     for (int i = 0; i < BATTERY_SAMPLES; i++) {
-        voltage += analogRead(Pins::BATT) * BatteryConfig::REAL_MV_PER_LSB;
+        raw[i] = analogRead(Pins::BATT);
         delay(ADC_DELAY_MS);
     }
-    voltage /= BATTERY_SAMPLES;
     
     // Restore pin state
     digitalWrite(Pins::LOW_DIV, HIGH);
     
     // Convert to percentage
-    float percentage = ((voltage - BatteryConfig::VMIN) / 
-                       (BatteryConfig::VMAX - BatteryConfig::VMIN)) * 100;
-    return constrain(percentage, 0.0f, 100.0f);
+    trace.recordBattery(raw, BATTERY_SAMPLES);
+    return SignalChain::batteryLevel(raw, BATTERY_SAMPLES);
 }
 
 bool PowerManager::isLowBattery() {
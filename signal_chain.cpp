@@ -0,0 +1,66 @@
+// processing/signal_chain.cpp
+#include "signal_chain.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+double SignalChain::sweepMagnitude(const int16_t* real, const int16_t* imag, uint8_t points) {
+    double magnitude = 0;
+
+    for (uint8_t i = 1; i < points; i++) {
+        double magnread = sqrt(pow(real[i], 2) + pow(imag[i], 2));
+        magnitude = (i == 1) ? magnread : (magnitude + magnread) / 2;
+    }
+    return magnitude;
+}
+
+double SignalChain::impedance(float sumMagnitude, uint8_t validSamples, double gain) {
+    return (validSamples > 0) ? 1/((sumMagnitude / validSamples)*gain)-SERIES_OHMS : -1;
+}
+
+double SignalChain::capacitance(double impedance, uint32_t freq) {
+    return 1E+12 / (2 * M_PI * freq * impedance);
+}
+
+float SignalChain::tempCompensation(float capacitance, float temp) {
+    return capacitance * (1 + TEMP_COEFF * (temp - REF_TEMP));
+}
+
+int SignalChain::moisture(double capacitance, int Cmin, int Cmax) {
+    double percent = fabs((capacitance - Cmin) * 100 / (Cmax - Cmin));
+    return (int)(percent > 100 ? 100 : percent);
+}
+
+int SignalChain::sweepMoisture(const SweepSum& sweeps, double gain, int Cmin, int Cmax, float temp,
+                               uint32_t freq, double* impedance, double* capacitance) {
+    double imp = SignalChain::impedance(sweeps.magnitude, sweeps.valid, gain);
+    if (impedance) *impedance = imp;
+    if (imp < 0) return -1;
+
+    double Cin = tempCompensation(SignalChain::capacitance(imp, freq), temp);
+    if (capacitance) *capacitance = Cin;
+    return moisture(Cin, Cmin, Cmax);
+}
+
+int SignalChain::temperature(int16_t count) {
+    return (int)lroundf(count * TMP102_LSB_C);
+}
+
+float SignalChain::celsius(int16_t count) {
+    return count * TMP102_LSB_C;
+}
+
+float SignalChain::batteryLevel(const uint16_t* raw, uint8_t samples) {
+    float voltage = 0;
+
+    for (uint8_t i = 0; i < samples; i++) {
+        voltage += raw[i] * BatteryConfig::REAL_MV_PER_LSB;
+    }
+    voltage /= samples;
+
+    float percentage = ((voltage - BatteryConfig::VMIN) /
+                       (BatteryConfig::VMAX - BatteryConfig::VMIN)) * 100;
+    return percentage < 0 ? 0 : (percentage > 100 ? 100 : percentage);
+}
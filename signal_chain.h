@@ -0,0 +1,59 @@
+// processing/signal_chain.h
+#ifndef SIGNAL_CHAIN_H
+#define SIGNAL_CHAIN_H
+
+#include "config.h"
+
+// Hardware-free conversion steps from raw sensor readings to the values that
+// are transmitted. The firmware and the host trace replay both call these,
+// so they must not depend on Arduino APIs.
+namespace SignalChain {
+    constexpr float TEMP_COEFF = 0.02;
+    constexpr float REF_TEMP = 25.0;
+    constexpr double SERIES_OHMS = 204;     // Fixed resistance in series with the probe
+    constexpr float TMP102_LSB_C = 0.0625F;
+
+    // AD5933 sweep: NUM_SAMPLES sweeps of NUM_POINTS points per measurement,
+    // capacitance is taken at the mid frequency
+    constexpr uint32_t START_FREQ = 99930;
+    constexpr uint16_t FREQ_INCR = 10;
+    constexpr uint8_t NUM_INCR = 12;
+    constexpr uint8_t NUM_POINTS = NUM_INCR + 1;
+    constexpr uint8_t NUM_SAMPLES = 5;
+    constexpr uint32_t MID_FREQ = START_FREQ + FREQ_INCR * NUM_INCR / 2;
+
+    // Sweep magnitudes of one measurement; sweeps without signal are left out
+    struct SweepSum {
+        float magnitude = 0;
+        uint8_t valid = 0;
+
+        void add(double sweepMagnitude) {
+            if (sweepMagnitude > 0) {
+                magnitude += sweepMagnitude;
+                valid++;
+            }
+        }
+    };
+
+    // Magnitude of one sweep; the first point is discarded while the
+    // excitation settles and the rest are folded into a running average.
+    double sweepMagnitude(const int16_t* real, const int16_t* imag, uint8_t points);
+
+    // Impedance from the summed magnitudes of the valid sweeps, -1 if none
+    double impedance(float sumMagnitude, uint8_t validSamples, double gain);
+
+    double capacitance(double impedance, uint32_t freq);
+    float tempCompensation(float capacitance, float temp);
+    int moisture(double capacitance, int Cmin, int Cmax);
+
+    // Whole chain from the summed sweeps to moisture, -1 if no sweep was
+    // valid. Impedance and compensated capacitance are returned for logging.
+    int sweepMoisture(const SweepSum& sweeps, double gain, int Cmin, int Cmax, float temp,
+                      uint32_t freq = MID_FREQ, double* impedance = nullptr, double* capacitance = nullptr);
+
+    int temperature(int16_t count);         // Nearest whole degree, halves away from zero
+    float celsius(int16_t count);           // Unrounded, used for compensation
+    float batteryLevel(const uint16_t* raw, uint8_t samples);
+}
+
+#endif // SIGNAL_CHAIN_H
@@ -1,22 +1,130 @@
 // sensors/temperature.cpp
 #include "temperature.h"
+#include "signal_chain.h"
+#include "trace_recorder.h"
 
-bool TemperatureSensor::initialize() {
-    return STemp.begin();
+bool TemperatureSensor::initialize(bool extended) {
+    configReg = CONFIG_SHUTDOWN | (extended ? CONFIG_EXTENDED : 0);
+    converting = false;
+    return writeRegister(REG_CONFIG, configReg);
 }
 
-int TemperatureSensor::getTemperature() {
-    wakeup();
-    delay(50);
-    int temp = int(STemp.readTempC() + TEMP_OFFSET);
-    sleep();
-    return temp;
+bool TemperatureSensor::writeRegister(uint8_t reg, uint16_t value) {
+    Wire.beginTransmission(ADDRESS);
+    Wire.write(reg);
+    Wire.write(value >> 8);
+    Wire.write(value & 0xFF);
+    return Wire.endTransmission() == 0;
 }
 
-void TemperatureSensor::sleep() {
-    STemp.sleep();
+bool TemperatureSensor::readRegister(uint8_t reg, uint16_t& value) {
+    Wire.beginTransmission(ADDRESS);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0) return false;
+    if (Wire.requestFrom(ADDRESS, (uint8_t)2) != 2) return false;
+
+    uint8_t msb = Wire.read();
+    uint8_t lsb = Wire.read();
+    value = ((uint16_t)msb << 8) | lsb;
+    return true;
+}
+
+// Skip only while the real readings agree and the chain of predictions is short
+bool TemperatureSensor::shouldSkip(uint32_t nowMs) const {
+    if (historyCount < 2 || consecutiveSkips >= MAX_CONSECUTIVE_SKIPS) return false;
+
+    const Sample& last = history[(historyHead + HISTORY - 1) % HISTORY];
+    const Sample& prev = history[(historyHead + HISTORY - 2) % HISTORY];
+    if (nowMs - last.timeMs > MAX_PREDICT_AGE_MS) return false;
+    if (abs(last.value - prev.value) > SKIP_THRESHOLD) return false;
+    return abs(predict(nowMs) - last.value) <= SKIP_THRESHOLD;
+}
+
+// Linear extrapolation from the last two real readings, or the last reading
+// alone when the history is short or stale
+int16_t TemperatureSensor::predict(uint32_t nowMs) const {
+    if (historyCount == 0) return 0;
+
+    const Sample& last = history[(historyHead + HISTORY - 1) % HISTORY];
+    if (historyCount < 2 || nowMs - last.timeMs > MAX_PREDICT_AGE_MS) return last.value;
+
+    const Sample& prev = history[(historyHead + HISTORY - 2) % HISTORY];
+    uint32_t span = last.timeMs - prev.timeMs;
+    if (span == 0) return last.value;
+
+    int32_t delta = (int32_t)(last.value - prev.value) * (int32_t)(nowMs - last.timeMs) / (int32_t)span;
+    return last.value + delta;
+}
+
+void TemperatureSensor::addHistory(uint32_t nowMs, int16_t value) {
+    history[historyHead] = { nowMs, value };
+    historyHead = (historyHead + 1) % HISTORY;
+    if (historyCount < HISTORY) historyCount++;
 }
 
-void TemperatureSensor::wakeup() {
-    STemp.wakeup();
-}
\ No newline at end of file
+bool TemperatureSensor::startConversion(uint32_t nowMs) {
+    if (shouldSkip(nowMs)) {
+        converting = false;
+        stats.skipped++;
+        consecutiveSkips++;
+        return false;
+    }
+    converting = writeRegister(REG_CONFIG, configReg | CONFIG_ONE_SHOT);
+    return converting;
+}
+
+bool TemperatureSensor::isReady() {
+    uint16_t value;
+    return readRegister(REG_CONFIG, value) && (value & CONFIG_ONE_SHOT);
+}
+
+int16_t TemperatureSensor::read(uint32_t nowMs) {
+    predicted = !converting;
+
+    uint32_t waitUs = 0;
+    if (converting) {
+        converting = false;
+        uint32_t startUs = micros();
+        uint32_t waitedMs = 0;
+        while (!isReady()) {
+            if (waitedMs >= MAX_CONVERSION_MS) {
+                stats.timeouts++;
+                predicted = true;
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(2));
+            waitedMs += 2;
+        }
+        if (waitedMs == 0) stats.readyAtRead++;    // Fully hidden behind battery sampling
+        waitUs = micros() - startUs;
+    }
+
+    int16_t value;
+    uint16_t raw;
+    if (!predicted && readRegister(REG_TEMP, raw)) {
+        // Bit 0 flags the 13-bit extended format
+        value = (raw & 0x0001) ? (int16_t)raw >> 3 : (int16_t)raw >> 4;
+
+        stats.conversions++;
+        stats.waitSumUs += waitUs;
+        if (waitUs > stats.waitMaxUs) stats.waitMaxUs = waitUs;
+        addHistory(nowMs, value);
+        consecutiveSkips = 0;
+    } else {
+        predicted = true;
+        value = predict(nowMs);
+    }
+
+    trace.recordTemperature(value);
+    return value;
+}
+
+void TemperatureSensor::printStats() const {
+    uint32_t total = stats.conversions + stats.skipped;
+    Serial.printf("TMP102: %lu conversions, %lu ready at read, wait avg %lu us, max %lu us, "
+                  "%lu timeouts, skip rate %lu%%\n",
+                  stats.conversions, stats.readyAtRead,
+                  stats.conversions ? stats.waitSumUs / stats.conversions : 0,
+                  stats.waitMaxUs, stats.timeouts,
+                  total ? stats.skipped * 100 / total : 0);
+}
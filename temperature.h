@@ -4,13 +4,67 @@
 
 #include "main.h"
 
+// Conversion counters since boot
+struct TempStats {
+    uint32_t conversions;     // One-shot conversions read from the sensor
+    uint32_t skipped;         // Cycles served from the history instead
+    uint32_t timeouts;        // Conversions that never became ready, value predicted
+    uint32_t readyAtRead;     // Conversions already done when read() was called
+    uint32_t waitMaxUs;       // Time read() blocked for a conversion; the conversion
+    uint32_t waitSumUs;       // itself overlaps battery sampling and is not timed
+};
+
+// TMP102 driven directly over I2C in one-shot mode. The sensor stays shut
+// down between cycles; startConversion() triggers a single conversion and
+// returns at once, so other sensors can be read while it runs. Readings
+// are fixed point in 1/16 °C. When the recent history shows a slow drift
+// the conversion is skipped and the extrapolated value is used instead.
 class TemperatureSensor {
 public:
-    bool initialize();
-    int getTemperature();
-    void sleep();
-    void wakeup();
+    bool initialize(bool extended = true);
+
+    // Starts a conversion, or returns false when the history is good enough
+    bool startConversion(uint32_t nowMs);
+    bool isReady();
+
+    // Waits for the conversion started above (or predicts), in 1/16 °C
+    int16_t read(uint32_t nowMs);
+
+    bool lastWasPredicted() const { return predicted; }
+    const TempStats& getStats() const { return stats; }
+    void printStats() const;
 
 private:
-    static constexpr float TEMP_OFFSET = 0.5;
-};
\ No newline at end of file
+    struct Sample {
+        uint32_t timeMs;
+        int16_t value;
+    };
+
+    bool writeRegister(uint8_t reg, uint16_t value);
+    bool readRegister(uint8_t reg, uint16_t& value);
+    bool shouldSkip(uint32_t nowMs) const;
+    int16_t predict(uint32_t nowMs) const;
+    void addHistory(uint32_t nowMs, int16_t value);
+
+    static constexpr uint8_t ADDRESS = 0x48;
+    static constexpr uint8_t REG_TEMP = 0x00;
+    static constexpr uint8_t REG_CONFIG = 0x01;
+    static constexpr uint16_t CONFIG_SHUTDOWN = 0x61A0;    // SD, 4 Hz, comparator
+    static constexpr uint16_t CONFIG_EXTENDED = 0x0010;    // EM: 13-bit, up to 150 °C
+    static constexpr uint16_t CONFIG_ONE_SHOT = 0x8000;    // OS: reads 1 when done
+
+    static constexpr uint8_t MAX_CONVERSION_MS = 40;       // 26 ms typical, 35 ms max
+    static constexpr uint8_t HISTORY = 4;
+    static constexpr int16_t SKIP_THRESHOLD = 4;           // 0.25 °C between real readings
+    static constexpr uint8_t MAX_CONSECUTIVE_SKIPS = 3;
+    static constexpr uint32_t MAX_PREDICT_AGE_MS = 3600000UL;
+
+    uint16_t configReg = CONFIG_SHUTDOWN;
+    Sample history[HISTORY] = {};
+    uint8_t historyCount = 0;
+    uint8_t historyHead = 0;
+    uint8_t consecutiveSkips = 0;
+    bool converting = false;
+    bool predicted = false;
+    TempStats stats = {};
+};
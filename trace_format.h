@@ -0,0 +1,41 @@
+// processing/trace_format.h
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <stdint.h>
+
+// Raw sensor trace format, shared by the firmware recorder and the host
+// replay tool (extras/trace_replay).
+//
+// Every record is [type][body length][body...][crc8], little endian.
+// Over Serial each record is written as one line: "TRC " followed by the
+// record in hex, so traces can be cut out of a normal debug log.
+namespace TraceFormat {
+    constexpr uint8_t VERSION = 3;      // 2: compensation uses the unrounded temperature
+                                        // 3: Temp rounds to nearest below 0 C too
+    constexpr const char* LINE_PREFIX = "TRC ";
+    constexpr uint8_t MAX_BODY = 64;
+
+    enum RecordType : uint8_t {
+        REC_HEADER = 0x00,  // 'S','M','X','T', version, points, start freq (u32), freq incr (u16)
+        REC_CYCLE = 0x01,   // timestamp ms (u32)
+        REC_CAL = 0x02,     // channel, gain (double), Cmin (u16), Cmax (u16)
+        REC_SWEEP = 0x03,   // channel, sample, points, points x (real i16, imag i16)
+        REC_TEMP = 0x04,    // TMP102 count (i16, 1/16 C)
+        REC_BATT = 0x05,    // samples, samples x ADC (u16)
+        REC_RESULT = 0x06   // HL (i8), HH (i8), Temp (i16), Batt (i8)
+    };
+
+    // CRC-8, polynomial 0x07, over type, length and body
+    inline uint8_t crc8(const uint8_t* data, uint8_t length, uint8_t crc = 0) {
+        for (uint8_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+            }
+        }
+        return crc;
+    }
+}
+
+#endif // TRACE_FORMAT_H
@@ -0,0 +1,94 @@
+// processing/trace_recorder.cpp
+#include "trace_recorder.h"
+
+uint8_t TraceRecorder::put16(uint8_t* buf, uint16_t value) {
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+    return 2;
+}
+
+uint8_t TraceRecorder::put32(uint8_t* buf, uint32_t value) {
+    put16(buf, value & 0xFFFF);
+    put16(buf + 2, value >> 16);
+    return 4;
+}
+
+void TraceRecorder::write(uint8_t type, const uint8_t* body, uint8_t length) {
+    if (!TraceConfig::ENABLED || length > TraceFormat::MAX_BODY) {
+        return;
+    }
+
+    uint8_t head[2] = { type, length };
+    uint8_t crc = TraceFormat::crc8(body, length, TraceFormat::crc8(head, 2));
+
+    Serial.print(TraceFormat::LINE_PREFIX);
+    Serial.printf("%02X%02X", type, length);
+    for (uint8_t i = 0; i < length; i++) {
+        Serial.printf("%02X", body[i]);
+    }
+    Serial.printf("%02X\n", crc);
+}
+
+void TraceRecorder::begin(uint8_t points, uint32_t startFreq, uint16_t freqIncr) {
+    uint8_t body[12] = { 'S', 'M', 'X', 'T', TraceFormat::VERSION, points };
+    put32(body + 6, startFreq);
+    put16(body + 10, freqIncr);
+    write(TraceFormat::REC_HEADER, body, sizeof(body));
+}
+
+void TraceRecorder::beginCycle(uint32_t timestamp) {
+    uint8_t body[4];
+    put32(body, timestamp);
+    write(TraceFormat::REC_CYCLE, body, sizeof(body));
+}
+
+void TraceRecorder::beginChannel(uint8_t ch, double gain, uint16_t Cmin, uint16_t Cmax) {
+    uint8_t body[1 + sizeof(double) + 4];
+    channel = ch;
+    body[0] = ch;
+    memcpy(body + 1, &gain, sizeof(double));
+    put16(body + 1 + sizeof(double), Cmin);
+    put16(body + 3 + sizeof(double), Cmax);
+    write(TraceFormat::REC_CAL, body, sizeof(body));
+}
+
+void TraceRecorder::recordSweep(uint8_t sample, const int16_t* real, const int16_t* imag, uint8_t points) {
+    uint8_t body[TraceFormat::MAX_BODY];
+    if (3 + points * 4 > TraceFormat::MAX_BODY) {
+        return;
+    }
+
+    body[0] = channel;
+    body[1] = sample;
+    body[2] = points;
+    for (uint8_t i = 0; i < points; i++) {
+        put16(body + 3 + i * 4, real[i]);
+        put16(body + 5 + i * 4, imag[i]);
+    }
+    write(TraceFormat::REC_SWEEP, body, 3 + points * 4);
+}
+
+void TraceRecorder::recordTemperature(int16_t count) {
+    uint8_t body[2];
+    put16(body, count);
+    write(TraceFormat::REC_TEMP, body, sizeof(body));
+}
+
+void TraceRecorder::recordBattery(const uint16_t* raw, uint8_t samples) {
+    uint8_t body[TraceFormat::MAX_BODY];
+    if (1 + samples * 2 > TraceFormat::MAX_BODY) {
+        return;
+    }
+
+    body[0] = samples;
+    for (uint8_t i = 0; i < samples; i++) {
+        put16(body + 1 + i * 2, raw[i]);
+    }
+    write(TraceFormat::REC_BATT, body, 1 + samples * 2);
+}
+
+void TraceRecorder::recordResult(int8_t hl, int8_t hh, int16_t temp, int8_t batt) {
+    uint8_t body[5] = { (uint8_t)hl, (uint8_t)hh, 0, 0, (uint8_t)batt };
+    put16(body + 2, temp);
+    write(TraceFormat::REC_RESULT, body, sizeof(body));
+}
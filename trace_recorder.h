@@ -0,0 +1,29 @@
+// processing/trace_recorder.h
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include "main.h"
+#include "trace_format.h"
+
+// Writes raw sensor data to Serial in the TraceFormat encoding. Recording
+// is off unless TraceConfig::ENABLED is set, so the calls cost nothing in
+// normal builds.
+class TraceRecorder {
+public:
+    void begin(uint8_t points, uint32_t startFreq, uint16_t freqIncr);
+    void beginCycle(uint32_t timestamp);
+    void beginChannel(uint8_t channel, double gain, uint16_t Cmin, uint16_t Cmax);
+    void recordSweep(uint8_t sample, const int16_t* real, const int16_t* imag, uint8_t points);
+    void recordTemperature(int16_t count);
+    void recordBattery(const uint16_t* raw, uint8_t samples);
+    void recordResult(int8_t hl, int8_t hh, int16_t temp, int8_t batt);
+
+private:
+    void write(uint8_t type, const uint8_t* body, uint8_t length);
+    static uint8_t put16(uint8_t* buf, uint16_t value);
+    static uint8_t put32(uint8_t* buf, uint32_t value);
+
+    uint8_t channel = 0;
+};
+
+#endif // TRACE_RECORDER_H
@@ -0,0 +1,42 @@
+// tasks/wake_scheduler.cpp
+#include "wake_scheduler.h"
+
+static constexpr uint32_t FNV_OFFSET = 2166136261UL;
+static constexpr uint32_t FNV_PRIME = 16777619UL;
+
+WakeScheduler::WakeScheduler()
+    : nodeHash(0), offsetMs(0), synced(false), lastSlot(0), lastPeriodMs(0), missed(0) {}
+
+// FNV-1a over DevEUI then serial number
+void WakeScheduler::setIdentity(const uint8_t* devEui, uint8_t length, uint16_t serial) {
+    uint32_t hash = FNV_OFFSET;
+    for (uint8_t i = 0; i < length; i++) {
+        hash = (hash ^ devEui[i]) * FNV_PRIME;
+    }
+    hash = (hash ^ (serial & 0xFF)) * FNV_PRIME;
+    hash = (hash ^ (serial >> 8)) * FNV_PRIME;
+    nodeHash = hash;
+}
+
+void WakeScheduler::sync(uint32_t localMs, uint64_t epochMs) {
+    if (epochMs < localMs) return;
+    offsetMs = epochMs - localMs;
+    synced = true;
+    lastPeriodMs = 0;   // Slot numbers change with the epoch
+}
+
+uint32_t WakeScheduler::nextWake(uint32_t nowMs, uint32_t periodMs) {
+    if (periodMs < MIN_PERIOD_MS) periodMs = MIN_PERIOD_MS;
+    uint32_t phase = phaseMs(periodMs);
+    uint64_t now = toEpochMs(nowMs);
+    uint64_t slot = (now + periodMs - phase) / periodMs;
+
+    // Re-arming before the slot (e.g. after a downlink measurement) keeps it
+    if (periodMs == lastPeriodMs && slot > lastSlot + 1) {
+        missed += (uint32_t)(slot - lastSlot - 1);
+    }
+    lastSlot = slot;
+    lastPeriodMs = periodMs;
+
+    return (uint32_t)(slot * periodMs + phase - offsetMs);
+}
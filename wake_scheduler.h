@@ -0,0 +1,40 @@
+// tasks/wake_scheduler.h
+#ifndef WAKE_SCHEDULER_H
+#define WAKE_SCHEDULER_H
+
+#include <stdint.h>
+
+// Absolute wake schedule. Wakes fall on epoch + k * period + phase, so time
+// spent awake never pushes later wakes back. The phase is a hash of the
+// node's DevEUI and serial number, which spreads nodes that were powered on
+// together across the period. Until a time sync arrives, the epoch is the
+// local clock's zero (boot).
+class WakeScheduler {
+public:
+    WakeScheduler();
+
+    void setIdentity(const uint8_t* devEui, uint8_t length, uint16_t serial);
+    void sync(uint32_t localMs, uint64_t epochMs);   // Epoch time at localMs
+
+    uint32_t phaseMs(uint32_t periodMs) const { return periodMs ? nodeHash % periodMs : 0; }
+
+    // Local time of the first slot after nowMs. Periods below MIN_PERIOD_MS
+    // are raised to it.
+    uint32_t nextWake(uint32_t nowMs, uint32_t periodMs);
+
+    uint64_t toEpochMs(uint32_t localMs) const { return localMs + offsetMs; }
+    bool isSynced() const { return synced; }
+    uint32_t missedSlots() const { return missed; }
+
+    static constexpr uint32_t MIN_PERIOD_MS = 60000UL;
+
+private:
+    uint32_t nodeHash;
+    uint64_t offsetMs;      // Epoch minus local time
+    bool synced;
+    uint64_t lastSlot;
+    uint32_t lastPeriodMs;
+    uint32_t missed;
+};
+
+#endif // WAKE_SCHEDULER_H